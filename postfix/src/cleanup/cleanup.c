@@ -195,6 +195,10 @@
 /*	Optional list of \fIname=value\fR pairs that specify default
 /*	values for arbitrary macros that Postfix may send to Milter
 /*	applications.
+/* .IP "\fBmilter_connection_reuse (no)\fR"
+/*	Keep the connection to a Milter application open after a
+/*	session ends, and use it for the next session, instead of
+/*	connecting and negotiating again.
 /* MIME PROCESSING CONTROLS
 /* .ad
 /* .fi
@@ -10,12 +10,21 @@
 /*	int	fd;
 /*	int	lock_style;
 /*	VSTRING	*why;
+/*
+/*	int	deliver_flock_tries(fd, lock_style, why, tries)
+/*	int	fd;
+/*	int	lock_style;
+/*	VSTRING	*why;
+/*	int	tries;
 /* DESCRIPTION
 /*	deliver_flock() sets one exclusive kernel lock on an open file,
 /*	for example in order to deliver mail.
 /*	It performs several non-blocking attempts to acquire an exclusive
 /*	lock before giving up.
 /*
+/*	deliver_flock_tries() makes the specified number of attempts,
+/*	instead of the number given with deliver_lock_attempts.
+/*
 /*	Arguments:
 /* .IP fd
 /*	A file descriptor that is associated with an open file.
@@ -23,8 +32,10 @@
 /*	A locking style defined in myflock(3).
 /* .IP why
 /*	A null pointer, or storage for diagnostics.
+/* .IP tries
+/*	The number of locking attempts.
 /* DIAGNOSTICS
-/*	deliver_flock() returns -1 in case of problems, 0 in case
+/*	deliver_flock() and deliver_flock_tries() return -1 in case of problems, 0 in case
 /*	of success. The reason for failure is returned via the \fIwhy\fR
 /*	parameter.
 /* CONFIGURATION PARAMETERS
@@ -62,9 +73,9 @@
 
 #define MILLION	1000000
 
-/* deliver_flock - lock open file for mail delivery */
+/* deliver_flock_tries - lock open file, with explicit retry count */
 
-int     deliver_flock(int fd, int lock_style, VSTRING *why)
+int     deliver_flock_tries(int fd, int lock_style, VSTRING *why, int tries)
 {
     int     i;
 
@@ -72,7 +83,7 @@ int     deliver_flock(int fd, int lock_style, VSTRING *why)
 	if (myflock(fd, lock_style,
 		    MYFLOCK_OP_EXCLUSIVE | MYFLOCK_OP_NOWAIT) == 0)
 	    return (0);
-	if (i >= var_flock_tries)
+	if (i >= tries)
 	    break;
 	rand_sleep(var_flock_delay * MILLION, var_flock_delay * MILLION / 2);
     }
@@ -80,3 +91,10 @@ int     deliver_flock(int fd, int lock_style, VSTRING *why)
 	vstring_sprintf(why, "unable to lock for exclusive access: %m");
     return (-1);
 }
+
+/* deliver_flock - lock open file for mail delivery */
+
+int     deliver_flock(int fd, int lock_style, VSTRING *why)
+{
+    return (deliver_flock_tries(fd, lock_style, why, var_flock_tries));
+}
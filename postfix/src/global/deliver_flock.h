@@ -21,6 +21,7 @@
   * External interface.
   */
 extern int deliver_flock(int, int, VSTRING *);
+extern int deliver_flock_tries(int, int, VSTRING *, int);
 
 /* LICENSE
 /* .ad
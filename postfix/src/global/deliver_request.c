@@ -65,6 +65,11 @@
 /* .IP \fBDEL_REQ_FLAG_BOUNCE\fR
 /*	Delete bounced recipients from the queue file. Currently,
 /*	this flag is non-functional.
+/* .IP \fBDEL_REQ_FLAG_BATCH\fR
+/*	The client may send another request over the same connection.
+/*	A delivery agent that supports this calls deliver_request_read()
+/*	again after deliver_request_done(), until the former returns
+/*	a null result. Other delivery agents simply disconnect.
 /* .PP
 /*	The \fBDEL_REQ_FLAG_DEFLT\fR constant provides a convenient shorthand
 /*	for the most common case: delete successful and bounced recipients.
@@ -178,8 +183,13 @@ static int deliver_request_final(VSTREAM *stream, DELIVER_REQUEST *request,
      * supposed to behave! The workaround is to wait until the receiver
      * closes the connection. Calling VSTREAM_GETC() has the benefit of using
      * whatever timeout is specified in the ipc_timeout parameter.
+     * 
+     * When the queue manager may send another request over the same
+     * connection, it first waits for our initial status, so we must not
+     * block here.
      */
-    (void) VSTREAM_GETC(stream);
+    if ((request->flags & DEL_REQ_FLAG_BATCH) == 0)
+	(void) VSTREAM_GETC(stream);
     return (err);
 }
 
@@ -367,6 +377,7 @@ static DELIVER_REQUEST *deliver_request_alloc(void)
 
     request = (DELIVER_REQUEST *) mymalloc(sizeof(*request));
     request->fp = 0;
+    request->flags = 0;
     request->queue_name = 0;
     request->queue_id = 0;
     request->nexthop = 0;
@@ -74,6 +74,7 @@ typedef struct DELIVER_REQUEST {
 #define DEL_REQ_FLAG_CONN_LOAD	(1<<11)	/* Consult opportunistic cache */
 #define DEL_REQ_FLAG_CONN_STORE	(1<<12)	/* Update opportunistic cache */
 #define DEL_REQ_FLAG_REC_DLY_SENT	(1<<13)	/* Record delayed delivery */
+#define DEL_REQ_FLAG_BATCH	(1<<14)	/* More requests may follow */
 
  /*
   * Cache Load and Store as value or mask. Use explicit _MASK for multi-bit
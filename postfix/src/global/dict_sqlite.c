@@ -50,8 +50,19 @@
 /*	Lookups which exceed the limit fail with dict->error=DICT_ERR_RETRY.
 /*	Note that each non-empty (and non-NULL) column of a
 /*	multi-column result row counts as one result.
+/* .IP mmap_size
+/*	The size in bytes of the database region that SQLite reads
+/*	through a memory mapping instead of read() calls. The mapped
+/*	pages are shared with other processes that use the same
+/*	database. Zero means use the SQLite default.
 /* .IP "select_field, where_field, additional_conditions"
 /*	Legacy query interface.
+/* .PP
+/*	When every substitution in the query template is a complete
+/*	single-quoted SQL string ('%s', '%u', etc.), the query is
+/*	compiled once when the table is opened, and each lookup only
+/*	binds the substituted values. Other query templates are
+/*	expanded and compiled for each lookup.
 /* SEE ALSO
 /*	dict(3) generic dictionary manager
 /* AUTHOR(S)
@@ -103,6 +114,9 @@ typedef struct {
     void   *ctx;			/* db_common_parse() context */
     char   *dbpath;			/* dbpath config attribute */
     int     expansion_limit;		/* expansion_limit config attribute */
+    int     mmap_size;			/* mmap_size config attribute */
+    sqlite3_stmt *stmt;			/* pre-compiled query, or null */
+    char   *params;			/* query parameter substitutions */
 } DICT_SQLITE;
 
 /* dict_sqlite_quote - escape SQL metacharacters in input string */
@@ -129,12 +143,16 @@ static void dict_sqlite_close(DICT *dict)
     if (msg_verbose)
 	msg_info("%s: %s", myname, dict_sqlite->parser->name);
 
+    if (dict_sqlite->stmt)
+	(void) sqlite3_finalize(dict_sqlite->stmt);
     if (sqlite3_close(dict_sqlite->db) != SQLITE_OK)
 	msg_fatal("%s: close %s failed", myname, dict_sqlite->parser->name);
     cfg_parser_free(dict_sqlite->parser);
     myfree(dict_sqlite->dbpath);
     myfree(dict_sqlite->query);
     myfree(dict_sqlite->result_format);
+    if (dict_sqlite->params)
+	myfree(dict_sqlite->params);
     if (dict_sqlite->ctx)
 	db_common_free_ctx(dict_sqlite->ctx);
     if (dict->fold_buf)
@@ -152,7 +170,11 @@ static const char *dict_sqlite_lookup(DICT *dict, const char *name)
     const char *query_remainder;
     static VSTRING *query;
     static VSTRING *result;
+    static VSTRING *param;
+    char    param_fmt[3];
+    const char *query_text;
     const char *retval;
+    const char *cp;
     int     expansion = 0;
     int     status;
     int     domain_rc;
@@ -207,23 +229,59 @@ static const char *dict_sqlite_lookup(DICT *dict, const char *name)
 
     INIT_VSTR(query, 10);
 
-    if (!db_common_expand(dict_sqlite->ctx, dict_sqlite->query,
-			  name, 0, query, dict_sqlite_quote))
-	return (0);
-
-    if (msg_verbose)
-	msg_info("%s: %s: Searching with query %s",
-		 myname, dict_sqlite->parser->name, vstring_str(query));
-
-    if (sqlite3_prepare_v2(dict_sqlite->db, vstring_str(query), -1,
-			   &sql_stmt, &query_remainder) != SQLITE_OK)
-	msg_fatal("%s: %s: SQL prepare failed: %s\n",
-		  myname, dict_sqlite->parser->name,
-		  sqlite3_errmsg(dict_sqlite->db));
+    if ((sql_stmt = dict_sqlite->stmt) != 0) {
+
+	/*
+	 * Bind each substitution to its parameter in the pre-compiled query.
+	 * SQLite copies the value, so that the buffer can be reused.
+	 */
+	INIT_VSTR(param, 10);
+	param_fmt[0] = '%';
+	param_fmt[2] = 0;
+	for (cp = dict_sqlite->params; *cp; cp++) {
+	    param_fmt[1] = *cp;
+	    VSTRING_RESET(param);
+	    VSTRING_TERMINATE(param);
+	    if (!db_common_expand(dict_sqlite->ctx, param_fmt,
+				  name, 0, param, 0)) {
+		(void) sqlite3_clear_bindings(sql_stmt);
+		return (0);
+	    }
+	    if (sqlite3_bind_text(sql_stmt, cp - dict_sqlite->params + 1,
+				  vstring_str(param), VSTRING_LEN(param),
+				  SQLITE_TRANSIENT) != SQLITE_OK)
+		msg_fatal("%s: %s: SQL bind failed: %s",
+			  myname, dict_sqlite->parser->name,
+			  sqlite3_errmsg(dict_sqlite->db));
+	    if (msg_verbose)
+		vstring_sprintf_append(query, "%s%s=%s",
+				       cp > dict_sqlite->params ? ", " : "",
+				       param_fmt, vstring_str(param));
+	}
+	if (msg_verbose)
+	    msg_info("%s: %s: Searching with parameters %s",
+		     myname, dict_sqlite->parser->name, vstring_str(query));
+	query_text = dict_sqlite->query;
+    } else {
+	if (!db_common_expand(dict_sqlite->ctx, dict_sqlite->query,
+			      name, 0, query, dict_sqlite_quote))
+	    return (0);
 
-    if (*query_remainder && msg_verbose)
-	msg_info("%s: %s: Ignoring text at end of query: %s",
-		 myname, dict_sqlite->parser->name, query_remainder);
+	if (msg_verbose)
+	    msg_info("%s: %s: Searching with query %s",
+		     myname, dict_sqlite->parser->name, vstring_str(query));
+
+	if (sqlite3_prepare_v2(dict_sqlite->db, vstring_str(query), -1,
+			       &sql_stmt, &query_remainder) != SQLITE_OK)
+	    msg_fatal("%s: %s: SQL prepare failed: %s\n",
+		      myname, dict_sqlite->parser->name,
+		      sqlite3_errmsg(dict_sqlite->db));
+
+	if (*query_remainder && msg_verbose)
+	    msg_info("%s: %s: Ignoring text at end of query: %s",
+		     myname, dict_sqlite->parser->name, query_remainder);
+	query_text = vstring_str(query);
+    }
 
     /*
      * Retrieve and expand the result(s).
@@ -246,19 +304,24 @@ static const char *dict_sqlite_lookup(DICT *dict, const char *name)
 	else {
 	    msg_warn("%s: %s: SQL step failed for query '%s': %s\n",
 		     myname, dict_sqlite->parser->name,
-		     vstring_str(query), sqlite3_errmsg(dict_sqlite->db));
+		     query_text, sqlite3_errmsg(dict_sqlite->db));
 	    dict->error = DICT_ERR_RETRY;
 	    break;
 	}
     }
 
     /*
-     * Clean up.
+     * Clean up. Reset a pre-compiled query instead of destroying it; this
+     * also ends the implicit read transaction, so that the database is not
+     * kept locked between lookups.
      */
-    if (sqlite3_finalize(sql_stmt))
+    if (sql_stmt == dict_sqlite->stmt) {
+	(void) sqlite3_reset(sql_stmt);
+	(void) sqlite3_clear_bindings(sql_stmt);
+    } else if (sqlite3_finalize(sql_stmt))
 	msg_fatal("%s: %s: SQL finalize failed for query '%s': %s\n",
 		  myname, dict_sqlite->parser->name,
-		  vstring_str(query), sqlite3_errmsg(dict_sqlite->db));
+		  query_text, sqlite3_errmsg(dict_sqlite->db));
 
     return ((dict->error == 0 && *(retval = vstring_str(result)) != 0) ?
 	    retval : 0);
@@ -286,6 +349,8 @@ static void sqlite_parse_config(DICT_SQLITE *dict_sqlite, const char *sqlitecf)
 	cfg_get_str(dict_sqlite->parser, "result_format", "%s", 1, 0);
     dict_sqlite->expansion_limit =
 	cfg_get_int(dict_sqlite->parser, "expansion_limit", 0, 0, 0);
+    dict_sqlite->mmap_size =
+	cfg_get_int(dict_sqlite->parser, "mmap_size", 0, 0, 0);
 
     /*
      * Parse the query / result templates and the optional domain filter.
@@ -306,6 +371,70 @@ static void sqlite_parse_config(DICT_SQLITE *dict_sqlite, const char *sqlitecf)
 	dict_sqlite->dict.flags |= DICT_FLAG_FIXED;
 }
 
+/* dict_sqlite_prepare - pre-compile query template */
+
+static void dict_sqlite_prepare(DICT_SQLITE *dict_sqlite)
+{
+    const char *myname = "dict_sqlite_prepare";
+    VSTRING *sql;
+    VSTRING *params;
+    const char *cp;
+    const char *query_remainder;
+    int     in_string = 0;
+
+    /*
+     * Replace each '%x' SQL string with a query parameter. Give up on any
+     * other substitution, such as one inside a longer SQL string; those
+     * queries are expanded for each lookup.
+     */
+    sql = vstring_alloc(100);
+    params = vstring_alloc(10);
+    for (cp = dict_sqlite->query; *cp; cp++) {
+	if (*cp == '%') {
+	    if (cp[1] != '%')
+		break;
+	    VSTRING_ADDCH(sql, *cp++);
+	} else if (*cp == '\'' && !in_string && cp[1] == '%'
+		   && cp[2] != 0 && cp[2] != '%' && cp[3] == '\'') {
+	    VSTRING_ADDCH(sql, '?');
+	    VSTRING_ADDCH(params, cp[2]);
+	    cp += 3;
+	} else {
+	    if (*cp == '\'')
+		in_string = !in_string;
+	    VSTRING_ADDCH(sql, *cp);
+	}
+    }
+    VSTRING_TERMINATE(sql);
+    VSTRING_TERMINATE(params);
+
+    if (*cp != 0 || VSTRING_LEN(params) == 0) {
+	if (msg_verbose)
+	    msg_info("%s: %s: query is expanded for each lookup",
+		     myname, dict_sqlite->parser->name);
+    } else if (sqlite3_prepare_v2(dict_sqlite->db, vstring_str(sql), -1,
+				  &dict_sqlite->stmt,
+				  &query_remainder) != SQLITE_OK) {
+	msg_warn("%s: %s: cannot pre-compile query \"%s\": %s",
+		 myname, dict_sqlite->parser->name, vstring_str(sql),
+		 sqlite3_errmsg(dict_sqlite->db));
+	dict_sqlite->stmt = 0;
+    } else if (sqlite3_bind_parameter_count(dict_sqlite->stmt)
+	       != (int) VSTRING_LEN(params)) {
+	(void) sqlite3_finalize(dict_sqlite->stmt);
+	dict_sqlite->stmt = 0;
+    } else {
+	dict_sqlite->params = vstring_export(params);
+	params = 0;
+	if (msg_verbose)
+	    msg_info("%s: %s: pre-compiled query %s",
+		     myname, dict_sqlite->parser->name, vstring_str(sql));
+    }
+    vstring_free(sql);
+    if (params)
+	vstring_free(params);
+}
+
 /* dict_sqlite_open - open sqlite database */
 
 DICT   *dict_sqlite_open(const char *name, int open_flags, int dict_flags)
@@ -341,6 +470,24 @@ DICT   *dict_sqlite_open(const char *name, int open_flags, int dict_flags)
 	msg_fatal("%s:%s: Can't open database: %s\n",
 		  DICT_TYPE_SQLITE, name, sqlite3_errmsg(dict_sqlite->db));
 
+    /*
+     * Read the database through a shared memory mapping, instead of copying
+     * it into each process's private page cache.
+     */
+    if (dict_sqlite->mmap_size > 0) {
+	VSTRING *pragma = vstring_alloc(100);
+
+	vstring_sprintf(pragma, "PRAGMA mmap_size=%d", dict_sqlite->mmap_size);
+	if (sqlite3_exec(dict_sqlite->db, vstring_str(pragma),
+			 0, 0, 0) != SQLITE_OK)
+	    msg_warn("%s:%s: %s: %s", DICT_TYPE_SQLITE, name,
+		     vstring_str(pragma), sqlite3_errmsg(dict_sqlite->db));
+	vstring_free(pragma);
+    }
+    dict_sqlite->stmt = 0;
+    dict_sqlite->params = 0;
+    dict_sqlite_prepare(dict_sqlite);
+
     dict_sqlite->dict.owner = cfg_get_owner(dict_sqlite->parser);
 
     return (DICT_DEBUG (&dict_sqlite->dict));
@@ -10,6 +10,11 @@
 /*	const char *path;
 /*	VSTRING	*why;
 /*
+/*	int	dot_lockfile_tries(path, why, tries)
+/*	const char *path;
+/*	VSTRING	*why;
+/*	int	tries;
+/*
 /*	void	dot_unlockfile(path)
 /*	const char *path;
 /* DESCRIPTION
@@ -18,6 +23,9 @@
 /*	times and attempts to break stale locks. A negative result value
 /*	means no lock file could be created.
 /*
+/*	dot_lockfile_tries() makes the specified number of attempts,
+/*	instead of the number given with deliver_lock_attempts.
+/*
 /*	dot_unlockfile() attempts to remove the lock file created by
 /*	dot_lockfile(). The operation always succeeds, and therefore
 /*	it preserves the errno value.
@@ -28,8 +36,10 @@
 /* .IP why
 /*	A null pointer, or storage for the reason why a lock file could
 /*	not be created.
+/* .IP tries
+/*	The number of attempts to create the lock file.
 /* DIAGNOSTICS
-/*	dot_lockfile() returns 0 upon success. In case of failure, the
+/*	dot_lockfile() and dot_lockfile_tries() return 0 upon success. In case of failure, the
 /*	result is -1, and the errno variable is set appropriately:
 /*	EEXIST when a "fresh" lock file already exists; other values as
 /*	appropriate.
@@ -75,9 +85,9 @@
 
 #define MILLION	1000000
 
-/* dot_lockfile - create user.lock file */
+/* dot_lockfile_tries - create user.lock file, with explicit retry count */
 
-int     dot_lockfile(const char *path, VSTRING *why)
+int     dot_lockfile_tries(const char *path, VSTRING *why, int tries)
 {
     char   *lock_file;
     int     count;
@@ -99,7 +109,7 @@ int     dot_lockfile(const char *path, VSTRING *why)
 	    status = 0;
 	    break;
 	}
-	if (count >= var_flock_tries)
+	if (count >= tries)
 	    break;
 
 	/*
@@ -128,6 +138,13 @@ int     dot_lockfile(const char *path, VSTRING *why)
     return (status);
 }
 
+/* dot_lockfile - create user.lock file */
+
+int     dot_lockfile(const char *path, VSTRING *why)
+{
+    return (dot_lockfile_tries(path, why, var_flock_tries));
+}
+
 /* dot_unlockfile - remove .lock file */
 
 void    dot_unlockfile(const char *path)
@@ -20,6 +20,7 @@
   * External interface.
   */
 extern int dot_lockfile(const char *, VSTRING *);
+extern int dot_lockfile_tries(const char *, VSTRING *, int);
 extern void dot_unlockfile(const char *);
 
 /* LICENSE
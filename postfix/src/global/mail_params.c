@@ -56,6 +56,8 @@
 /*	char	*var_hash_queue_names;
 /*	int	var_hash_queue_depth;
 /*	int	var_trigger_timeout;
+/*	bool	var_trigger_reuse;
+/*	bool	var_milt_conn_reuse;
 /*	char	*var_rcpt_delim;
 /*	int	var_fork_tries;
 /*	int	var_fork_delay;
@@ -67,6 +69,7 @@
 /*	time_t	var_starttime;
 /*	int	var_ownreq_special;
 /*	int	var_daemon_timeout;
+/*	char	*var_daemon_cpu_affinity;
 /*	char	*var_syslog_facility;
 /*	char	*var_relay_domains;
 /*	char	*var_fflush_domains;
@@ -99,6 +102,8 @@
 /*	int	var_db_create_buf;
 /*	int	var_db_read_buf;
 /*	long	var_lmdb_map_size;
+/*	int	var_remote_cache_time;
+/*	int	var_remote_cache_size;
 /*	int	var_proc_limit;
 /*	int	var_mime_maxdepth;
 /*	int	var_mime_bound_len;
@@ -193,6 +198,7 @@
 #include <dict.h>
 #include <dict_db.h>
 #include <dict_lmdb.h>
+#include <dict_result_cache.h>
 #include <inet_proto.h>
 #include <vstring_vstream.h>
 #include <iostuff.h>
@@ -260,6 +266,8 @@ char   *var_db_type;
 char   *var_hash_queue_names;
 int     var_hash_queue_depth;
 int     var_trigger_timeout;
+bool    var_trigger_reuse;
+bool    var_milt_conn_reuse;
 char   *var_rcpt_delim;
 int     var_fork_tries;
 int     var_fork_delay;
@@ -271,6 +279,7 @@ int     var_soft_bounce;
 time_t  var_starttime;
 int     var_ownreq_special;
 int     var_daemon_timeout;
+char   *var_daemon_cpu_affinity;
 char   *var_syslog_facility;
 char   *var_relay_domains;
 char   *var_fflush_domains;
@@ -303,6 +312,8 @@ char   *var_proxywrite_service;
 int     var_db_create_buf;
 int     var_db_read_buf;
 long    var_lmdb_map_size;
+int     var_remote_cache_time;
+int     var_remote_cache_size;
 int     var_proc_limit;
 int     var_mime_maxdepth;
 int     var_mime_bound_len;
@@ -692,6 +703,7 @@ void    mail_params_init()
 	VAR_PROXYMAP_SERVICE, DEF_PROXYMAP_SERVICE, &var_proxymap_service, 1, 0,
 	VAR_PROXYWRITE_SERVICE, DEF_PROXYWRITE_SERVICE, &var_proxywrite_service, 1, 0,
 	VAR_INT_FILT_CLASSES, DEF_INT_FILT_CLASSES, &var_int_filt_classes, 0, 0,
+	VAR_DAEMON_CPU_AFFINITY, DEF_DAEMON_CPU_AFFINITY, &var_daemon_cpu_affinity, 0, 0,
 	/* multi_instance_wrapper may have dependencies but not dependents. */
 	VAR_MULTI_WRAPPER, DEF_MULTI_WRAPPER, &var_multi_wrapper, 0, 0,
 	VAR_DSN_FILTER, DEF_DSN_FILTER, &var_dsn_filter, 0, 0,
@@ -721,6 +733,7 @@ void    mail_params_init()
 	VAR_MIME_BOUND_LEN, DEF_MIME_BOUND_LEN, &var_mime_bound_len, 1, 0,
 	VAR_DELAY_MAX_RES, DEF_DELAY_MAX_RES, &var_delay_max_res, MIN_DELAY_MAX_RES, MAX_DELAY_MAX_RES,
 	VAR_INET_WINDOW, DEF_INET_WINDOW, &var_inet_windowsize, 0, 0,
+	VAR_REMOTE_CACHE_SIZE, DEF_REMOTE_CACHE_SIZE, &var_remote_cache_size, 1, 0,
 	0,
     };
     static const CONFIG_LONG_TABLE long_defaults[] = {
@@ -740,6 +753,7 @@ void    mail_params_init()
 	VAR_FLOCK_STALE, DEF_FLOCK_STALE, &var_flock_stale, 1, 0,
 	VAR_DAEMON_TIMEOUT, DEF_DAEMON_TIMEOUT, &var_daemon_timeout, 1, 0,
 	VAR_IN_FLOW_DELAY, DEF_IN_FLOW_DELAY, &var_in_flow_delay, 0, 10,
+	VAR_REMOTE_CACHE_TIME, DEF_REMOTE_CACHE_TIME, &var_remote_cache_time, 0, 0,
 	0,
     };
     static const CONFIG_BOOL_TABLE bool_defaults[] = {
@@ -755,6 +769,8 @@ void    mail_params_init()
 	VAR_VERIFY_NEG_CACHE, DEF_VERIFY_NEG_CACHE, &var_verify_neg_cache,
 	VAR_OLDLOG_COMPAT, DEF_OLDLOG_COMPAT, &var_oldlog_compat,
 	VAR_HELPFUL_WARNINGS, DEF_HELPFUL_WARNINGS, &var_helpful_warnings,
+	VAR_TRIGGER_REUSE, DEF_TRIGGER_REUSE, &var_trigger_reuse,
+	VAR_MILT_CONN_REUSE, DEF_MILT_CONN_REUSE, &var_milt_conn_reuse,
 	VAR_CYRUS_SASL_AUTHZID, DEF_CYRUS_SASL_AUTHZID, &var_cyrus_sasl_authzid,
 	VAR_MULTI_ENABLE, DEF_MULTI_ENABLE, &var_multi_enable,
 	VAR_LONG_QUEUE_IDS, DEF_LONG_QUEUE_IDS, &var_long_queue_ids,
@@ -856,6 +872,8 @@ void    mail_params_init()
     check_overlap();
     dict_db_cache_size = var_db_read_buf;
     dict_lmdb_map_size = var_lmdb_map_size;
+    dict_result_cache_time = var_remote_cache_time;
+    dict_result_cache_size = var_remote_cache_size;
     inet_windowsize = var_inet_windowsize;
 
     /*
@@ -888,6 +888,13 @@ extern int var_throttle_time;
 #define DEF_MASTER_DISABLE	""
 extern char *var_master_disable;
 
+ /*
+  * Master: how often to log per-service usage statistics.
+  */
+#define VAR_MASTER_STAT_TIME	"master_status_update_time"
+#define DEF_MASTER_STAT_TIME	"0s"
+extern int var_master_stat_time;
+
  /*
   * Any subsystem: default maximum number of clients serviced before a mail
   * subsystem terminates (except queue manager).
@@ -1228,6 +1235,10 @@ extern int var_smtpd_junk_cmd_limit;
 #define DEF_SMTPD_RCPT_OVERLIM	1000
 extern int var_smtpd_rcpt_overlim;
 
+#define VAR_SMTPD_RCPT_PREFETCH	"smtpd_recipient_prefetch_limit"
+#define DEF_SMTPD_RCPT_PREFETCH	0
+extern int var_smtpd_rcpt_prefetch;
+
 #define VAR_SMTPD_HIST_THRSH	"smtpd_history_flush_threshold"
 #define DEF_SMTPD_HIST_THRSH	100
 extern int var_smtpd_hist_thrsh;
@@ -1973,6 +1984,14 @@ extern int var_daemon_timeout;
 #define DEF_QMGR_DAEMON_TIMEOUT	"1000s"
 extern int var_qmgr_daemon_timeout;
 
+ /*
+  * The CPUs that a daemon process may run on. Specify with "-o" in master.cf
+  * to pin a service to CPUs or to a NUMA node.
+  */
+#define VAR_DAEMON_CPU_AFFINITY	"daemon_cpu_affinity"
+#define DEF_DAEMON_CPU_AFFINITY	""
+extern char *var_daemon_cpu_affinity;
+
  /*
   * How long an intra-mail command may take before we assume the mail system
   * is in deadlock (should never happen).
@@ -1992,6 +2011,10 @@ extern int var_qmgr_ipc_timeout;
 #define DEF_TRIGGER_TIMEOUT	"10s"
 extern int var_trigger_timeout;
 
+#define VAR_TRIGGER_REUSE	"trigger_connection_reuse"
+#define DEF_TRIGGER_REUSE	0
+extern bool var_trigger_reuse;
+
  /*
   * SMTP server restrictions. What networks I am willing to relay from, what
   * domains I am willing to forward mail from or to, what clients I refuse to
@@ -2306,6 +2329,10 @@ extern char *var_smtpd_exp_filter;
 #define DEF_SMTPD_PEERNAME_LOOKUP	1
 extern bool var_smtpd_peername_lookup;
 
+#define VAR_SMTPD_PEERNAME_ASYNC	"smtpd_peername_lookup_async"
+#define DEF_SMTPD_PEERNAME_ASYNC	0
+extern bool var_smtpd_peername_async;
+
  /*
   * Heuristic to reject unknown local recipients at the SMTP port.
   */
@@ -2844,6 +2871,17 @@ extern int var_db_read_buf;
 #define DEF_LMDB_MAP_SIZE		(16 * 1024 *1024)
 extern long var_lmdb_map_size;
 
+ /*
+  * Lookup result cache for tcp and socketmap tables.
+  */
+#define VAR_REMOTE_CACHE_TIME		"remote_table_cache_time"
+#define DEF_REMOTE_CACHE_TIME		"0s"
+extern int var_remote_cache_time;
+
+#define VAR_REMOTE_CACHE_SIZE		"remote_table_cache_size"
+#define DEF_REMOTE_CACHE_SIZE		1000
+extern int var_remote_cache_size;
+
  /*
   * Named queue file attributes.
   */
@@ -3232,6 +3270,10 @@ extern char *var_cleanup_milters;
 #define DEF_MILT_DEF_ACTION		"tempfail"
 extern char *var_milt_def_action;
 
+#define VAR_MILT_CONN_REUSE		"milter_connection_reuse"
+#define DEF_MILT_CONN_REUSE		0
+extern bool var_milt_conn_reuse;
+
 #define VAR_MILT_CONN_MACROS		"milter_connect_macros"
 #define DEF_MILT_CONN_MACROS		"j {daemon_name} v"
 extern char *var_milt_conn_macros;
@@ -3401,6 +3443,15 @@ extern int var_dest_rate_delay;
 #define DEF_XPORT_RATE_DELAY	"0s"
 extern int var_xport_rate_delay;
 
+#define VAR_DELIVERY_BATCH	"default_delivery_batch_limit"
+#define _DELIVERY_BATCH		"_delivery_batch_limit"
+#define DEF_DELIVERY_BATCH	1
+extern int var_delivery_batch;
+
+#define VAR_QMGR_CHECKPOINT	"qmgr_checkpoint_interval"
+#define DEF_QMGR_CHECKPOINT	"0s"
+extern int var_qmgr_checkpoint;
+
  /*
   * Stress handling.
   */
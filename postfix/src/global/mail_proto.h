@@ -99,6 +99,7 @@
   * Generic triggers.
   */
 #define TRIGGER_REQ_WAKEUP	'W'	/* wakeup */
+#define TRIGGER_REQ_PERSIST	'P'	/* keep connection open */
 
  /*
   * Queue manager requests.
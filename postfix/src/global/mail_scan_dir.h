@@ -21,6 +21,11 @@
   */
 extern char *mail_scan_dir_next(SCAN_DIR *);
 
+ /*
+  * How many queue file names to read at a time, and to visit in inode order.
+  */
+#define MAIL_SCAN_DIR_BATCH	1000
+
 /* LICENSE
 /* .ad
 /* .fi
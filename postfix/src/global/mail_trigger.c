@@ -17,6 +17,15 @@
 /*	server endpoints, a short-running program should invoke
 /*	event_drain() to ensure proper request delivery.
 /*
+/*	When trigger_connection_reuse is enabled, mail_trigger()
+/*	keeps the FIFO or socket connection open for subsequent
+/*	requests to the same endpoint, instead of connecting and
+/*	disconnecting for each request. A request is silently
+/*	dropped when the endpoint has not yet read earlier requests;
+/*	the server will wake up for those anyway. When a persistent
+/*	connection breaks, mail_trigger() falls back to the
+/*	non-persistent method.
+/*
 /*	Arguments:
 /* .IP class
 /*	Name of a class of local transport channel endpoints,
@@ -53,6 +62,10 @@
 
 #include <sys_defs.h>
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
 
 /* Utility library. */
 
@@ -61,12 +74,140 @@
 #include <iostuff.h>
 #include <trigger.h>
 #include <warn_stat.h>
+#include <htable.h>
+#include <vstring.h>
+#include <vstream.h>
+#include <safe_open.h>
+#include <connect.h>
 
 /* Global library. */
 
 #include "mail_params.h"
 #include "mail_proto.h"
 
+#define MAIL_TRIGGER_FIFO	1	/* FIFO endpoint */
+#define MAIL_TRIGGER_SOCK	2	/* socket endpoint */
+
+ /*
+  * Persistent trigger connections, indexed by endpoint pathname.
+  */
+typedef struct {
+    int     fd;				/* open FIFO or socket */
+} MAIL_TRIGGER_CONN;
+
+static HTABLE *mail_trigger_conns;
+
+/* mail_trigger_write - send request without blocking */
+
+static int mail_trigger_write(int fd, const char *buf, ssize_t len)
+{
+    ssize_t count;
+
+    /*
+     * If the FIFO or socket buffer is full, then the server has not yet
+     * read earlier requests. There is no need to wait until we can add
+     * another one.
+     */
+    while (len > 0) {
+	if ((count = write(fd, buf, len)) < 0) {
+	    if (errno == EINTR)
+		continue;
+	    return (errno == EAGAIN ? 0 : -1);
+	}
+	buf += count;
+	len -= count;
+    }
+    return (0);
+}
+
+/* mail_trigger_drop - forget persistent connection */
+
+static void mail_trigger_drop(const char *path)
+{
+    MAIL_TRIGGER_CONN *conn;
+
+    if ((conn = (MAIL_TRIGGER_CONN *)
+	 htable_find(mail_trigger_conns, path)) != 0) {
+	(void) close(conn->fd);
+	htable_delete(mail_trigger_conns, path, myfree);
+    }
+}
+
+/* mail_trigger_reuse - send request over existing connection */
+
+static int mail_trigger_reuse(const char *path, const char *req_buf,
+			              ssize_t req_len)
+{
+    MAIL_TRIGGER_CONN *conn;
+
+    if (mail_trigger_conns == 0
+	|| (conn = (MAIL_TRIGGER_CONN *)
+	    htable_find(mail_trigger_conns, path)) == 0)
+	return (-1);
+    if (mail_trigger_write(conn->fd, req_buf, req_len) < 0) {
+	if (msg_verbose)
+	    msg_info("persistent trigger %s: %m -- reconnecting", path);
+	mail_trigger_drop(path);
+	return (-1);
+    }
+    return (0);
+}
+
+/* mail_trigger_open - open persistent connection and send request */
+
+static int mail_trigger_open(const char *path, int type,
+			             const char *req_buf, ssize_t req_len)
+{
+    static VSTRING *why;
+    static VSTRING *buf;
+    MAIL_TRIGGER_CONN *conn;
+    VSTREAM *fp;
+    int     fd;
+
+    if (why == 0) {
+	why = vstring_alloc(100);
+	buf = vstring_alloc(100);
+	mail_trigger_conns = htable_create(1);
+    }
+
+    /*
+     * A FIFO has no connection, so there is no need to tell the server that
+     * we will send more requests. As with fifo_trigger(), use safe_open() so
+     * that we don't follow symlinks.
+     */
+    if (type == MAIL_TRIGGER_FIFO) {
+	if ((fp = safe_open(path, O_WRONLY | O_NONBLOCK, 0,
+			    (struct stat *) 0, -1, -1, why)) == 0) {
+	    if (msg_verbose)
+		msg_info("open %s: %s", path, vstring_str(why));
+	    return (-1);
+	}
+	fd = vstream_fileno(fp);
+	(void) vstream_fdclose(fp);
+	VSTRING_RESET(buf);
+    } else {
+	if ((fd = LOCAL_CONNECT(path, BLOCKING, var_trigger_timeout)) < 0) {
+	    if (msg_verbose)
+		msg_info("connect to %s: %m", path);
+	    return (-1);
+	}
+	non_blocking(fd, NON_BLOCKING);
+	vstring_sprintf(buf, "%c", TRIGGER_REQ_PERSIST);
+    }
+    close_on_exec(fd, CLOSE_ON_EXEC);
+    vstring_memcat(buf, req_buf, req_len);
+    if (mail_trigger_write(fd, vstring_str(buf), VSTRING_LEN(buf)) < 0) {
+	if (msg_verbose)
+	    msg_info("write %s: %m", path);
+	(void) close(fd);
+	return (-1);
+    }
+    conn = (MAIL_TRIGGER_CONN *) mymalloc(sizeof(*conn));
+    conn->fd = fd;
+    (void) htable_enter(mail_trigger_conns, path, (void *) conn);
+    return (0);
+}
+
 /* mail_trigger - trigger a service */
 
 int     mail_trigger(const char *class, const char *service,
@@ -81,14 +222,22 @@ int     mail_trigger(const char *class, const char *service,
      * (fifo) or a UNIX-domain socket. So we may have to try both.
      */
     path = mail_pathname(class, service);
-    if ((status = stat(path, &st)) < 0) {
+    if (var_trigger_reuse && mail_trigger_reuse(path, req_buf, req_len) == 0) {
+	status = 0;
+    } else if ((status = stat(path, &st)) < 0) {
 	 msg_warn("unable to look up %s: %m", path);
     } else if (S_ISFIFO(st.st_mode)) {
-	status = fifo_trigger(path, req_buf, req_len, var_trigger_timeout);
+	if (var_trigger_reuse == 0
+	    || (status = mail_trigger_open(path, MAIL_TRIGGER_FIFO,
+					   req_buf, req_len)) < 0)
+	    status = fifo_trigger(path, req_buf, req_len, var_trigger_timeout);
 	if (status < 0 && S_ISSOCK(st.st_mode))
 	    status = LOCAL_TRIGGER(path, req_buf, req_len, var_trigger_timeout);
     } else if (S_ISSOCK(st.st_mode)) {
-	status = LOCAL_TRIGGER(path, req_buf, req_len, var_trigger_timeout);
+	if (var_trigger_reuse == 0
+	    || (status = mail_trigger_open(path, MAIL_TRIGGER_SOCK,
+					   req_buf, req_len)) < 0)
+	    status = LOCAL_TRIGGER(path, req_buf, req_len, var_trigger_timeout);
     } else {
 	msg_warn("%s is not a socket or a fifo", path);
 	status = -1;
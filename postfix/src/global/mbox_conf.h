@@ -23,6 +23,7 @@
 #define MBOX_FCNTL_LOCK		(1<<1)
 #define MBOX_DOT_LOCK		(1<<2)
 #define MBOX_DOT_LOCK_MAY_FAIL	(1<<3)	/* XXX internal only */
+#define MBOX_LOCK_NOWAIT	(1<<4)	/* XXX internal only */
 
 extern int mbox_lock_mask(const char *);
 extern ARGV *mbox_lock_names(void);
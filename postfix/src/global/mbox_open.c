@@ -43,6 +43,10 @@
 /*	mbox_lock_mask(). Locks are applied to regular files only.
 /*	The result is a handle that must be destroyed by mbox_release().
 /*	The \fBdef_dsn\fR argument is given to mbox_dsn().
+/*	With \fBMBOX_LOCK_NOWAIT\fR in \fBlock_style\fR, mbox_open()
+/*	makes only one attempt to acquire each lock, instead of
+/*	retrying as specified with the flock_tries and flock_delay
+/*	parameters.
 /*
 /*	mbox_release() releases the named mailbox. It is up to the
 /*	application to close the stream.
@@ -95,6 +99,7 @@
 
 /* Global library. */
 
+#include <mail_params.h>
 #include <dot_lockfile.h>
 #include <deliver_flock.h>
 #include <mbox_conf.h>
@@ -111,10 +116,19 @@ MBOX   *mbox_open(const char *path, int flags, mode_t mode, struct stat * st,
     MBOX   *mp;
     int     locked = 0;
     VSTREAM *fp;
+    int     saved_errno;
+    int     lock_tries;
 
     if (st == 0)
 	st = &local_statbuf;
 
+    /*
+     * With MBOX_LOCK_NOWAIT, don't sleep between lock attempts. The caller
+     * will come back later when someone else has exclusive access.
+     */
+    lock_tries = (lock_style & MBOX_LOCK_NOWAIT) ? 1 : var_flock_tries;
+    lock_style &= ~MBOX_LOCK_NOWAIT;
+
     /*
      * If this is a regular file, create a dotlock file. This locking method
      * does not work well over NFS, but it is better than some alternatives.
@@ -138,10 +152,11 @@ MBOX   *mbox_open(const char *path, int flags, mode_t mode, struct stat * st,
      */
     if ((lock_style & MBOX_DOT_LOCK)
 	&& (stat(path, st) < 0 || S_ISREG(st->st_mode))) {
-	if (dot_lockfile(path, why->reason) == 0) {
+	if (dot_lockfile_tries(path, why->reason, lock_tries) == 0) {
 	    locked |= MBOX_DOT_LOCK;
 	} else if (errno == EEXIST) {
 	    dsb_status(why, mbox_dsn(EAGAIN, def_dsn));
+	    errno = EAGAIN;
 	    return (0);
 	} else if (lock_style & MBOX_DOT_LOCK_MAY_FAIL) {
 	    msg_warn("%s", vstring_str(why->reason));
@@ -176,17 +191,21 @@ MBOX   *mbox_open(const char *path, int flags, mode_t mode, struct stat * st,
      * problems.
      */
 #define HUNKY_DORY(lock_mask, myflock_style) ((lock_style & (lock_mask)) == 0 \
-         || deliver_flock(vstream_fileno(fp), (myflock_style), why->reason) == 0)
+         || deliver_flock_tries(vstream_fileno(fp), (myflock_style), \
+				why->reason, lock_tries) == 0)
 
     if (S_ISREG(st->st_mode)) {
 	if (HUNKY_DORY(MBOX_FLOCK_LOCK, MYFLOCK_STYLE_FLOCK)
 	    && HUNKY_DORY(MBOX_FCNTL_LOCK, MYFLOCK_STYLE_FCNTL)) {
 	    locked |= lock_style;
 	} else {
+	    saved_errno = errno;
 	    dsb_status(why, mbox_dsn(errno, def_dsn));
 	    if (locked & MBOX_DOT_LOCK)
 		dot_unlockfile(path);
 	    vstream_fclose(fp);
+	    errno = (saved_errno == EWOULDBLOCK || saved_errno == EACCES ?
+		     EAGAIN : saved_errno);
 	    return (0);
 	}
     }
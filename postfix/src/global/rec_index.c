@@ -0,0 +1,146 @@
+/*++
+/* NAME
+/*	rec_index 3
+/* SUMMARY
+/*	queue file section index
+/* SYNOPSIS
+/*	#include <rec_index.h>
+/*
+/*	int	rec_index_init(index, stream, flags)
+/*	REC_INDEX *index;
+/*	VSTREAM	*stream;
+/*	int	flags;
+/*
+/*	int	rec_index_seek(index, stream, section)
+/*	REC_INDEX *index;
+/*	VSTREAM	*stream;
+/*	int	section;
+/* DESCRIPTION
+/*	This module allows programs to jump directly to a specific
+/*	section of a queue file, instead of reading all records
+/*	that precede it. The index is derived from the size record
+/*	that the cleanup server writes at the start of each queue
+/*	file.
+/*
+/*	rec_index_init() reads the first record at the current
+/*	stream position, and fills in the index when that record
+/*	is a well-formed size record. The stream is positioned
+/*	back at the first record, so that the caller can still
+/*	read all records in the usual manner. The result value is
+/*	the type of the first record, or REC_TYPE_ERROR in case
+/*	of a read error or a malformed size record. When the file
+/*	has no size record, the result is a different record type,
+/*	and REC_INDEX_OK() is false. With input that is not seekable,
+/*	rec_index_init() reads nothing, and returns 0.
+/*
+/*	rec_index_seek() positions the stream at the specified
+/*	section. The result is 0 in case of success, -1 when the
+/*	index has no information about the section, or when the
+/*	stream is not seekable.
+/*
+/*	Arguments:
+/* .IP index
+/*	Pointer to caller-owned storage.
+/* .IP stream
+/*	Queue file, opened for reading.
+/* .IP flags
+/*	Record read flags, as with rec_get_raw().
+/* .IP section
+/*	One of the following.
+/* .RS
+/* .IP REC_INDEX_SECT_ENV
+/*	The initial envelope segment, starting with the size record.
+/* .IP REC_INDEX_SECT_CONTENT
+/*	The first message header record.
+/* .IP REC_INDEX_SECT_XTRA
+/*	The extracted segment marker, which is followed by the
+/*	envelope records that were extracted from the message
+/*	content.
+/* .RE
+/* DIAGNOSTICS
+/*	Warnings: malformed size record.
+/* SEE ALSO
+/*	record(3), queue file record I/O
+/*	cleanup(8), queue file creation
+/* LICENSE
+/* .ad
+/* .fi
+/*	The Secure Mailer license must be distributed with this software.
+/* AUTHOR(S)
+/*	Wietse Venema
+/*	IBM T.J. Watson Research
+/*	P.O. Box 704
+/*	Yorktown Heights, NY 10598, USA
+/*--*/
+
+/* System library. */
+
+#include <sys_defs.h>
+#include <stdio.h>			/* sscanf() */
+
+/* Utility library. */
+
+#include <msg.h>
+#include <vstring.h>
+#include <vstream.h>
+
+/* Global library. */
+
+#include <record.h>
+#include <rec_type.h>
+#include <rec_index.h>
+
+/* rec_index_init - read size record and build index */
+
+int     rec_index_init(REC_INDEX *index, VSTREAM *fp, int flags)
+{
+    static VSTRING *buf;
+    int     rec_type;
+
+    if (buf == 0)
+	buf = vstring_alloc(100);
+
+    index->data_offset = index->data_size = -1;
+    if ((index->env_offset = vstream_ftell(fp)) < 0)
+	return (0);
+    if ((rec_type = rec_get_raw(fp, buf, 0, flags)) == REC_TYPE_SIZE) {
+	if (sscanf(vstring_str(buf), "%ld %ld",
+		   &index->data_size, &index->data_offset) != 2
+	    || index->data_offset <= 0 || index->data_size <= 0) {
+	    msg_warn("%s: invalid size record: %.100s",
+		     VSTREAM_PATH(fp), vstring_str(buf));
+	    index->data_offset = index->data_size = -1;
+	    rec_type = REC_TYPE_ERROR;
+	}
+    }
+    if (vstream_fseek(fp, index->env_offset, SEEK_SET) < 0)
+	return (REC_TYPE_ERROR);
+    return (rec_type);
+}
+
+/* rec_index_seek - jump to queue file section */
+
+int     rec_index_seek(REC_INDEX *index, VSTREAM *fp, int section)
+{
+    const char *myname = "rec_index_seek";
+    off_t   offset;
+
+    switch (section) {
+    case REC_INDEX_SECT_ENV:
+	offset = index->env_offset;
+	break;
+    case REC_INDEX_SECT_CONTENT:
+	if (!REC_INDEX_OK(index))
+	    return (-1);
+	offset = index->data_offset;
+	break;
+    case REC_INDEX_SECT_XTRA:
+	if (!REC_INDEX_OK(index))
+	    return (-1);
+	offset = index->data_offset + index->data_size;
+	break;
+    default:
+	msg_panic("%s: unknown section: %d", myname, section);
+    }
+    return (vstream_fseek(fp, offset, SEEK_SET) < 0 ? -1 : 0);
+}
@@ -0,0 +1,48 @@
+#ifndef _REC_INDEX_H_INCLUDED_
+#define _REC_INDEX_H_INCLUDED_
+
+/*++
+/* NAME
+/*	rec_index 3h
+/* SUMMARY
+/*	queue file section index
+/* SYNOPSIS
+/*	#include <rec_index.h>
+/* DESCRIPTION
+/* .nf
+
+ /*
+  * Utility library.
+  */
+#include <vstream.h>
+
+ /*
+  * External interface.
+  */
+typedef struct REC_INDEX {
+    off_t   env_offset;			/* initial envelope */
+    long    data_offset;		/* message content, or -1 */
+    long    data_size;			/* message content size, or -1 */
+} REC_INDEX;
+
+#define REC_INDEX_SECT_ENV	1	/* initial envelope */
+#define REC_INDEX_SECT_CONTENT	2	/* message headers and body */
+#define REC_INDEX_SECT_XTRA	3	/* extracted envelope */
+
+extern int rec_index_init(REC_INDEX *, VSTREAM *, int);
+extern int rec_index_seek(REC_INDEX *, VSTREAM *, int);
+
+#define REC_INDEX_OK(ip)	((ip)->data_offset > 0 && (ip)->data_size > 0)
+
+/* LICENSE
+/* .ad
+/* .fi
+/*	The Secure Mailer license must be distributed with this software.
+/* AUTHOR(S)
+/*	Wietse Venema
+/*	IBM T.J. Watson Research
+/*	P.O. Box 704
+/*	Yorktown Heights, NY 10598, USA
+/*--*/
+
+#endif
@@ -38,6 +38,13 @@
 /*
 /*	void	resolve_clnt_free(reply)
 /*	RESOLVE_REPLY *reply;
+/*
+/*	int	resolve_clnt_batch(class, sender, count, addresses, replies)
+/*	const char *class;
+/*	const char *sender;
+/*	int	count;
+/*	const char **addresses;
+/*	RESOLVE_REPLY **replies;
 /* DESCRIPTION
 /*	This module implements a mail address resolver client.
 /*
@@ -58,6 +65,16 @@
 /*	allow the caller to supply sender context that will be used
 /*	for sender-dependent relayhost lookup.
 /*
+/*	resolve_clnt_batch() resolves \fIcount\fR internal-form
+/*	addresses with one pipelined conversation, and stores the
+/*	results in the corresponding \fIreplies\fR elements. The
+/*	class argument is RESOLVE_REGULAR or RESOLVE_VERIFY. This
+/*	is a best-effort optimization: the result is 0 in case of
+/*	success, -1 in case of communication failure or a bad server
+/*	reply, and the caller is expected to fall back to the
+/*	one-at-a-time interface. The resolver service must support
+/*	request pipelining (Postfix 3.1 and later).
+/*
 /*	In the resolver reply, the flags member is the bit-wise OR of
 /*	zero or more of the following:
 /* .IP RESOLVE_FLAG_FINAL
@@ -287,6 +304,81 @@ void    resolve_clnt(const char *class, const char *sender,
     last_expire = time((time_t *) 0) + 30;	/* XXX make configurable */
 }
 
+/* resolve_clnt_batch - resolve multiple addresses, pipelined */
+
+int     resolve_clnt_batch(const char *class, const char *sender, int count,
+			           const char **addrs, RESOLVE_REPLY **replies)
+{
+    const char *myname = "resolve_clnt_batch";
+    VSTREAM *stream;
+    int     server_flags = 0;
+    int     flags;
+    int     status = 0;
+    int     n;
+
+    if (rewrite_clnt_stream == 0)
+	rewrite_clnt_stream = clnt_stream_create(MAIL_CLASS_PRIVATE,
+						 var_rewrite_service,
+						 var_ipc_idle_limit,
+						 var_ipc_ttl_limit);
+
+    /*
+     * Send all requests before reading the first reply. The requests are
+     * small, and the caller limits the batch size (smtpd allows at most 100
+     * addresses), so this will not deadlock on the socket buffer.
+     */
+    stream = clnt_stream_access(rewrite_clnt_stream);
+    errno = 0;
+    for (n = 0; n < count; n++) {
+	if (attr_print(stream, ATTR_FLAG_NONE,
+		       SEND_ATTR_STR(MAIL_ATTR_REQ, class),
+		       SEND_ATTR_STR(MAIL_ATTR_SENDER, sender),
+		       SEND_ATTR_STR(MAIL_ATTR_ADDR, addrs[n]),
+		       ATTR_TYPE_END) != 0) {
+	    status = -1;
+	    break;
+	}
+    }
+    if (status == 0 && vstream_fflush(stream) != 0)
+	status = -1;
+    for (n = 0; status == 0 && n < count; n++) {
+	if (attr_scan(stream, ATTR_FLAG_STRICT,
+		      RECV_ATTR_INT(MAIL_ATTR_FLAGS, &flags),
+		      RECV_ATTR_STR(MAIL_ATTR_TRANSPORT, replies[n]->transport),
+		      RECV_ATTR_STR(MAIL_ATTR_NEXTHOP, replies[n]->nexthop),
+		      RECV_ATTR_STR(MAIL_ATTR_RECIP, replies[n]->recipient),
+		      RECV_ATTR_INT(MAIL_ATTR_FLAGS, &replies[n]->flags),
+		      ATTR_TYPE_END) != 5) {
+	    status = -1;
+	} else if (STR(replies[n]->transport)[0] == 0
+		   || (STR(replies[n]->recipient)[0] == 0 && *addrs[n] != 0)) {
+	    msg_warn("%s: null transport or recipient result for: <%s>",
+		     myname, addrs[n]);
+	    status = -1;
+	} else {
+	    server_flags |= flags;
+	    if (msg_verbose)
+		msg_info("%s: `%s' -> `%s' -> transp=`%s' host=`%s' rcpt=`%s'",
+			 myname, sender, addrs[n], STR(replies[n]->transport),
+			 STR(replies[n]->nexthop), STR(replies[n]->recipient));
+	}
+    }
+
+    /*
+     * Don't retry. The caller falls back to the one-at-a-time interface.
+     */
+    if (status < 0) {
+	if (msg_verbose || (errno && errno != EPIPE && errno != ENOENT))
+	    msg_warn("problem talking to service %s: %m",
+		     var_rewrite_service);
+	clnt_stream_recover(rewrite_clnt_stream);
+    } else if (server_flags != 0) {
+	/* Server-requested disconnect. */
+	clnt_stream_recover(rewrite_clnt_stream);
+    }
+    return (status);
+}
+
 /* resolve_clnt_free - destroy reply */
 
 void    resolve_clnt_free(RESOLVE_REPLY *reply)
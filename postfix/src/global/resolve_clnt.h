@@ -50,6 +50,7 @@ typedef struct RESOLVE_REPLY {
 extern void resolve_clnt_init(RESOLVE_REPLY *);
 extern void resolve_clnt(const char *, const char *, const char *, RESOLVE_REPLY *);
 extern void resolve_clnt_free(RESOLVE_REPLY *);
+extern int resolve_clnt_batch(const char *, const char *, int, const char **, RESOLVE_REPLY **);
 
 #define RESOLVE_NULL_FROM	""
 
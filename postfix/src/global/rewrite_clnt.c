@@ -15,6 +15,12 @@
 /*	const char *ruleset;
 /*	const char *address;
 /*	VSTRING	*result;
+/*
+/*	int	rewrite_clnt_internal_batch(ruleset, count, addresses, results)
+/*	const char *ruleset;
+/*	int	count;
+/*	const char **addresses;
+/*	VSTRING	**results;
 /* DESCRIPTION
 /*	This module implements a mail address rewriting client.
 /*
@@ -26,6 +32,15 @@
 /*	rewrite_clnt_internal() performs the same functionality but takes
 /*	input in internal (unquoted) form, and produces output in internal
 /*	(unquoted) form.
+/*
+/*	rewrite_clnt_internal_batch() rewrites \fIcount\fR internal-form
+/*	addresses with one pipelined conversation, and stores the
+/*	internal-form results in the corresponding \fIresults\fR
+/*	elements. This is a best-effort optimization: the result is
+/*	0 in case of success, -1 in case of communication failure,
+/*	and the caller is expected to fall back to rewrite_clnt_internal().
+/*	The rewriting service must support request pipelining (Postfix
+/*	3.1 and later).
 /* DIAGNOSTICS
 /*	Warnings: communication failure. Fatal error: mail system is down.
 /* SEE ALSO
@@ -189,6 +204,75 @@ VSTRING *rewrite_clnt_internal(const char *ruleset, const char *addr, VSTRING *r
     return (result);
 }
 
+/* rewrite_clnt_internal_batch - rewrite multiple addresses, pipelined */
+
+int     rewrite_clnt_internal_batch(const char *rule, int count,
+				            const char **addrs, VSTRING **results)
+{
+    VSTREAM *stream;
+    VSTRING *src = vstring_alloc(100);
+    int     server_flags = 0;
+    int     flags;
+    int     status = 0;
+    int     n;
+
+    if (rewrite_clnt_stream == 0)
+	rewrite_clnt_stream = clnt_stream_create(MAIL_CLASS_PRIVATE,
+						 var_rewrite_service,
+						 var_ipc_idle_limit,
+						 var_ipc_ttl_limit);
+
+    /*
+     * Send all requests before reading the first reply. The requests are
+     * small, so this will not deadlock on the socket buffer with reasonable
+     * batch sizes.
+     */
+    stream = clnt_stream_access(rewrite_clnt_stream);
+    errno = 0;
+    for (n = 0; n < count; n++) {
+	quote_822_local(src, addrs[n]);
+	if (attr_print(stream, ATTR_FLAG_NONE,
+		       SEND_ATTR_STR(MAIL_ATTR_REQ, REWRITE_ADDR),
+		       SEND_ATTR_STR(MAIL_ATTR_RULE, rule),
+		       SEND_ATTR_STR(MAIL_ATTR_ADDR, STR(src)),
+		       ATTR_TYPE_END) != 0) {
+	    status = -1;
+	    break;
+	}
+    }
+    if (status == 0 && vstream_fflush(stream) != 0)
+	status = -1;
+    for (n = 0; status == 0 && n < count; n++) {
+	if (attr_scan(stream, ATTR_FLAG_STRICT,
+		      RECV_ATTR_INT(MAIL_ATTR_FLAGS, &flags),
+		      RECV_ATTR_STR(MAIL_ATTR_ADDR, src),
+		      ATTR_TYPE_END) != 2) {
+	    status = -1;
+	} else {
+	    unquote_822_local(results[n], STR(src));
+	    server_flags |= flags;
+	    if (msg_verbose)
+		msg_info("rewrite_clnt_internal_batch: %s: %s -> %s",
+			 rule, addrs[n], STR(results[n]));
+	}
+    }
+    vstring_free(src);
+
+    /*
+     * Don't retry. The caller falls back to the one-at-a-time interface.
+     */
+    if (status < 0) {
+	if (msg_verbose || (errno && errno != EPIPE && errno != ENOENT))
+	    msg_warn("problem talking to service %s: %m",
+		     var_rewrite_service);
+	clnt_stream_recover(rewrite_clnt_stream);
+    } else if (server_flags != 0) {
+	/* Server-requested disconnect. */
+	clnt_stream_recover(rewrite_clnt_stream);
+    }
+    return (status);
+}
+
 #ifdef TEST
 
 #include <stdlib.h>
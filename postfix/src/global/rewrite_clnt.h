@@ -29,6 +29,7 @@
 
 extern VSTRING *rewrite_clnt(const char *, const char *, VSTRING *);
 extern VSTRING *rewrite_clnt_internal(const char *, const char *, VSTRING *);
+extern int rewrite_clnt_internal_batch(const char *, int, const char **, VSTRING **);
 
 /* LICENSE
 /* .ad
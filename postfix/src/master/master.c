@@ -110,6 +110,11 @@
 /* .IP "\fBmaster_service_disable (empty)\fR"
 /*	Selectively disable \fBmaster\fR(8) listener ports by service type
 /*	or by service name and type.
+/* .PP
+/*	Available in Postfix version 3.1 and later:
+/* .IP "\fBmaster_status_update_time (0s)\fR"
+/*	How often the Postfix \fBmaster\fR(8) process logs per-service usage
+/*	statistics.
 /* MISCELLANEOUS CONTROLS
 /* .ad
 /* .fi
@@ -498,6 +503,7 @@ int     main(int argc, char **argv)
      * results when we SIGHUP the server to reload configuration files.
      */
     master_config();
+    master_stats_init();
     master_sigsetup();
     master_flow_init();
     msg_info("daemon started -- version %s, configuration %s",
@@ -538,6 +544,7 @@ int     main(int argc, char **argv)
 	    master_gotsighup = 0;		/* this first */
 	    master_vars_init();			/* then this */
 	    master_refresh();			/* then this */
+	    master_stats_init();
 	}
 	if (master_gotsigchld) {
 	    if (msg_verbose)
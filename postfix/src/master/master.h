@@ -8,6 +8,22 @@
 /* DESCRIPTION
 /* .nf
 
+ /*
+  * Per-service usage statistics, see master_stats.c.
+  */
+typedef struct MASTER_STATS {
+    unsigned long conn_count;		/* connections handed to children */
+    double  busy_time;			/* total child process busy time */
+    int     spawn_count;		/* child processes created */
+    int     throttle_count;		/* process creation suspended */
+    double  throttle_since;		/* suspended since */
+    double  throttle_time;		/* total time suspended */
+    int     limit_count;		/* process limit reached */
+    double  limit_since;		/* at process limit since */
+    double  limit_time;			/* total time at process limit */
+    int     backlog_max;		/* longest listen queue seen */
+} MASTER_STATS;
+
  /*
   * Server processes that provide the same service share a common "listen"
   * socket to accept connection requests, and share a common pipe to the
@@ -50,6 +66,7 @@ typedef struct MASTER_SERV {
     int     total_proc;			/* number of processes */
     int     throttle_delay;		/* failure recovery parameter */
     int     status_fd[2];		/* child status reports */
+    MASTER_STATS stats;			/* usage statistics */
     struct BINHASH *children;		/* linkage */
     struct MASTER_SERV *next;		/* linkage */
 } MASTER_SERV;
@@ -98,6 +115,7 @@ typedef struct MASTER_PROC {
     int     avail;			/* availability */
     MASTER_SERV *serv;			/* parent linkage */
     int     use_count;			/* number of service requests */
+    double  busy_since;			/* start of service request */
 } MASTER_PROC;
 
  /*
@@ -184,6 +202,14 @@ extern void master_spawn(MASTER_SERV *);
 extern void master_reap_child(void);
 extern void master_delete_children(MASTER_SERV *);
 
+ /*
+  * master_stats.c
+  */
+extern void master_stats_init(void);
+extern void master_stats_busy(MASTER_PROC *, int);
+extern void master_stats_limit(MASTER_SERV *, int);
+extern void master_stats_cleanup(MASTER_SERV *);
+
  /*
   * master_flow.c
   */
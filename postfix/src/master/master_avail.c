@@ -125,6 +125,7 @@ void    master_avail_listen(MASTER_SERV *serv)
 {
     const char *myname = "master_avail_listen";
     int     listen_flag;
+    int     at_limit = 0;
     time_t  now;
     int     n;
 
@@ -133,6 +134,7 @@ void    master_avail_listen(MASTER_SERV *serv)
      * master_avail_more() or master_avail_less(). To avoid mutual dependency
      * problems, the code below invokes no code in other master_XXX modules,
      * and modifies no data that is maintained by other master_XXX modules.
+     * The exception is master_stats_limit(), which only updates statistics.
      * 
      * When no-one else is monitoring the service's listen socket, start
      * monitoring the socket for connection requests. All this under the
@@ -148,6 +150,7 @@ void    master_avail_listen(MASTER_SERV *serv)
 	listen_flag = 1;
     } else {
 	listen_flag = 0;
+	at_limit = 1;
 	if (serv->stress_param_val != 0) {
 	    now = event_time();
 	    if (serv->busy_warn_time < now - 1000) {
@@ -162,6 +165,7 @@ void    master_avail_listen(MASTER_SERV *serv)
 	    }
 	}
     }
+    master_stats_limit(serv, at_limit);
     if (listen_flag && !MASTER_LISTENING(serv)) {
 	if (msg_verbose)
 	    msg_info("%s: enable events %s", myname, serv->name);
@@ -523,6 +523,11 @@ MASTER_SERV *get_master_ent()
      */
     serv->status_fd[0] = serv->status_fd[1] = -1;
 
+    /*
+     * Usage statistics.
+     */
+    memset((void *) &serv->stats, 0, sizeof(serv->stats));
+
     /*
      * Child process structures.
      */
@@ -85,6 +85,7 @@ void    master_stop_service(MASTER_SERV *serv)
     master_wakeup_cleanup(serv);
     master_status_cleanup(serv);
     master_avail_cleanup(serv);
+    master_stats_cleanup(serv);
     master_listen_cleanup(serv);
 }
 
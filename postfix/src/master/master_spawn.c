@@ -126,6 +126,7 @@ static void master_throttle(MASTER_SERV *serv)
      */
     if ((serv->flags & MASTER_FLAG_THROTTLE) == 0) {
 	serv->flags |= MASTER_FLAG_THROTTLE;
+	serv->stats.throttle_count++;
 	event_request_timer(master_unthrottle_wrapper, (void *) serv,
 			    serv->throttle_delay);
 	if (msg_verbose)
@@ -247,9 +248,11 @@ void    master_spawn(MASTER_SERV *serv)
 	proc->gen = master_generation;
 	proc->use_count = 0;
 	proc->avail = 0;
+	proc->busy_since = 0;
 	binhash_enter(master_child_table, (void *) &pid,
 		      sizeof(pid), (void *) proc);
 	serv->total_proc++;
+	serv->stats.spawn_count++;
 	master_avail_more(serv, proc);
 	if (serv->flags & MASTER_FLAG_CONDWAKE) {
 	    serv->flags &= ~MASTER_FLAG_CONDWAKE;
@@ -274,10 +277,12 @@ static void master_delete_child(MASTER_PROC *proc)
      */
     serv = proc->serv;
     serv->total_proc--;
-    if (proc->avail == MASTER_STAT_AVAIL)
+    if (proc->avail == MASTER_STAT_AVAIL) {
 	master_avail_less(serv, proc);
-    else
+    } else {
+	master_stats_busy(proc, MASTER_STAT_AVAIL);
 	master_avail_listen(serv);
+    }
     binhash_delete(master_child_table, (void *) &proc->pid,
 		   sizeof(proc->pid), (void (*) (void *)) 0);
     myfree((void *) proc);
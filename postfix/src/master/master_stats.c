@@ -0,0 +1,288 @@
+/*++
+/* NAME
+/*	master_stats 3
+/* SUMMARY
+/*	Postfix master - per-service usage statistics
+/* SYNOPSIS
+/*	#include "master.h"
+/*
+/*	void	master_stats_init()
+/*
+/*	void	master_stats_busy(proc, avail)
+/*	MASTER_PROC *proc;
+/*	int	avail;
+/*
+/*	void	master_stats_limit(serv, at_limit)
+/*	MASTER_SERV *serv;
+/*	int	at_limit;
+/*
+/*	void	master_stats_cleanup(serv)
+/*	MASTER_SERV *serv;
+/* DESCRIPTION
+/*	This module maintains per-service usage statistics, and
+/*	periodically logs them so that a service's process limit can
+/*	be sized from observed usage. The statistics are derived from
+/*	information that the master already has: child process status
+/*	updates, process creation, and process creation throttling.
+/*	The spawn and throttle counters are updated directly by the
+/*	master_spawn module.
+/*
+/*	master_stats_init() (re)starts the logging timer, using the
+/*	current master_status_update_time setting. A zero interval
+/*	turns off logging.
+/*
+/*	master_stats_busy() is called when a child process changes
+/*	from available to busy and vice versa, or when a busy process
+/*	goes away (with avail equal to MASTER_STAT_AVAIL). It counts
+/*	connections and accumulates child process busy time.
+/*
+/*	master_stats_limit() is called whenever the master re-evaluates
+/*	its listen socket monitoring policy, with a non-zero at_limit
+/*	argument when all processes are busy and no more can be created.
+/*	It accumulates the time that the service spends at its process
+/*	limit, and separately, the time that process creation is
+/*	throttled after errors; during that time, new clients wait
+/*	in the listen queue. On systems where the listen queue length
+/*	of a TCP socket can be queried, the queue is sampled once
+/*	per second while the service is at its limit, provided that
+/*	statistics logging is turned on.
+/*
+/*	master_stats_cleanup() cancels the listen queue sampling timer
+/*	for the named service. It is OK to call master_stats_cleanup()
+/*	even when no timer is active for the named service.
+/* DIAGNOSTICS
+/*	Statistics are logged as one "statistics:" record per service
+/*	that saw any activity during the logging interval. The counters
+/*	are reset after logging. The "busy" figure is the average number
+/*	of busy processes over the interval; it is the figure to compare
+/*	against the process limit.
+/* BUGS
+/*	There is no query interface; the master runs with root
+/*	privileges, and we do not add another way to talk to it.
+/*	Statistics are lost when a service is removed from master.cf.
+/* LICENSE
+/* .ad
+/* .fi
+/*	The Secure Mailer license must be distributed with this software.
+/*--*/
+
+/* System library. */
+
+#include <sys_defs.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+
+/* Utility library. */
+
+#include <msg.h>
+#include <events.h>
+#include <binhash.h>
+#include <mymalloc.h>
+
+/* Global library. */
+
+#include <mail_params.h>
+
+/* Application-specific. */
+
+#include "master_proto.h"
+#include "master.h"
+
+ /*
+  * Linux reports the accept queue length of a listening TCP socket in the
+  * tcpi_unacked field of TCP_INFO. Other systems use that field for its
+  * literal meaning, or do not have it.
+  */
+#if defined(LINUX2) && defined(TCP_INFO)
+#define MASTER_STATS_BACKLOG
+#endif
+
+#define MASTER_STATS_SAMPLE_TIME	1	/* listen queue sampling */
+
+static double master_stats_start;	/* start of logging interval */
+
+/* master_stats_now - high-resolution time stamp */
+
+static double master_stats_now(void)
+{
+    struct timeval tv;
+
+    GETTIMEOFDAY(&tv);
+    return (tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+/* master_stats_busy - account for child process status change */
+
+void    master_stats_busy(MASTER_PROC *proc, int avail)
+{
+    MASTER_STATS *stats = &proc->serv->stats;
+    double  now;
+
+    if (avail == MASTER_STAT_TAKEN) {
+	stats->conn_count++;
+	proc->busy_since = master_stats_now();
+    } else if (proc->busy_since > 0) {
+	now = master_stats_now();
+	stats->busy_time += now - proc->busy_since;
+	proc->busy_since = 0;
+    }
+}
+
+#ifdef MASTER_STATS_BACKLOG
+
+/* master_stats_sample - sample listen queue length */
+
+static void master_stats_sample(int unused_event, void *context)
+{
+    MASTER_SERV *serv = (MASTER_SERV *) context;
+    struct tcp_info info;
+    SOCKOPT_SIZE len;
+    int     n;
+
+    for (n = 0; n < serv->listen_fd_count; n++) {
+	len = sizeof(info);
+	if (getsockopt(serv->listen_fd[n], IPPROTO_TCP, TCP_INFO,
+		       (void *) &info, &len) < 0)
+	    continue;
+	if (serv->stats.backlog_max < (int) info.tcpi_unacked)
+	    serv->stats.backlog_max = info.tcpi_unacked;
+    }
+    if (var_master_stat_time > 0)
+	event_request_timer(master_stats_sample, (void *) serv,
+			    MASTER_STATS_SAMPLE_TIME);
+}
+
+#endif
+
+/* master_stats_limit - account for time spent at process limit */
+
+void    master_stats_limit(MASTER_SERV *serv, int at_limit)
+{
+    MASTER_STATS *stats = &serv->stats;
+    int     throttled = (MASTER_THROTTLED(serv) != 0);
+
+    /*
+     * A throttled service is not at its process limit, though it does not
+     * accept connections either. Don't lump the two together.
+     */
+    if (throttled && stats->throttle_since == 0) {
+	stats->throttle_since = master_stats_now();
+    } else if (!throttled && stats->throttle_since != 0) {
+	stats->throttle_time += master_stats_now() - stats->throttle_since;
+	stats->throttle_since = 0;
+    }
+    if (at_limit && stats->limit_since == 0) {
+	stats->limit_count++;
+	stats->limit_since = master_stats_now();
+#ifdef MASTER_STATS_BACKLOG
+	if (serv->type == MASTER_SERV_TYPE_INET && var_master_stat_time > 0)
+	    event_request_timer(master_stats_sample, (void *) serv,
+				MASTER_STATS_SAMPLE_TIME);
+#endif
+    } else if (!at_limit && stats->limit_since != 0) {
+	stats->limit_time += master_stats_now() - stats->limit_since;
+	stats->limit_since = 0;
+	master_stats_cleanup(serv);
+    }
+}
+
+/* master_stats_cleanup - stop listen queue sampling */
+
+void    master_stats_cleanup(MASTER_SERV *serv)
+{
+#ifdef MASTER_STATS_BACKLOG
+    event_cancel_timer(master_stats_sample, (void *) serv);
+#endif
+}
+
+/* master_stats_event - log and reset per-service statistics */
+
+static void master_stats_event(int unused_event, void *unused_context)
+{
+    MASTER_SERV *serv;
+    MASTER_STATS *stats;
+    MASTER_PROC *proc;
+    BINHASH_INFO **list;
+    BINHASH_INFO **ht;
+    double  now;
+    double  interval;
+
+    now = master_stats_now();
+    if ((interval = now - master_stats_start) <= 0)
+	interval = 1;
+    master_stats_start = now;
+
+    /*
+     * Charge busy time and time at the process limit to the interval in
+     * which it was spent, not to the interval in which it ends. Long
+     * sessions would otherwise show up as a spike.
+     */
+    if (master_child_table != 0) {
+	list = binhash_list(master_child_table);
+	for (ht = list; *ht; ht++) {
+	    proc = (MASTER_PROC *) ht[0]->value;
+	    if (proc->busy_since > 0) {
+		proc->serv->stats.busy_time += now - proc->busy_since;
+		proc->busy_since = now;
+	    }
+	}
+	myfree((void *) list);
+    }
+    for (serv = master_head; serv != 0; serv = serv->next) {
+	stats = &serv->stats;
+	if (stats->limit_since != 0) {
+	    stats->limit_time += now - stats->limit_since;
+	    stats->limit_since = now;
+	}
+	if (stats->throttle_since != 0) {
+	    stats->throttle_time += now - stats->throttle_since;
+	    stats->throttle_since = now;
+	}
+	if (stats->conn_count == 0 && stats->busy_time == 0
+	    && stats->spawn_count == 0 && stats->throttle_count == 0
+	    && stats->throttle_time == 0
+	    && stats->limit_count == 0 && stats->limit_time == 0)
+	    continue;
+	msg_info("statistics: service=%s(%s) connections=%lu busy=%.2f "
+		 "processes=%d/%d spawned=%d throttled=%d/%.1fs "
+		 "limit=%d/%.1fs max_backlog=%d interval=%.0fs",
+		 serv->ext_name, serv->name, stats->conn_count,
+		 stats->busy_time / interval, serv->total_proc,
+		 serv->max_proc, stats->spawn_count, stats->throttle_count,
+		 stats->throttle_time, stats->limit_count, stats->limit_time,
+		 stats->backlog_max, interval);
+	stats->conn_count = 0;
+	stats->busy_time = 0;
+	stats->spawn_count = 0;
+	stats->throttle_count = 0;
+	stats->throttle_time = 0;
+	stats->limit_count = 0;
+	stats->limit_time = 0;
+	stats->backlog_max = 0;
+    }
+    if (var_master_stat_time > 0)
+	event_request_timer(master_stats_event, (void *) 0,
+			    var_master_stat_time);
+}
+
+/* master_stats_init - start or stop statistics logging */
+
+void    master_stats_init(void)
+{
+    MASTER_SERV *serv;
+
+    if (var_master_stat_time > 0) {
+	if (master_stats_start == 0)
+	    master_stats_start = master_stats_now();
+	event_request_timer(master_stats_event, (void *) 0,
+			    var_master_stat_time);
+    } else {
+	event_cancel_timer(master_stats_event, (void *) 0);
+	master_stats_start = 0;
+	for (serv = master_head; serv != 0; serv = serv->next)
+	    master_stats_cleanup(serv);
+    }
+}
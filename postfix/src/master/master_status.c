@@ -133,9 +133,11 @@ static void master_status_event(int event, void *context)
     switch (stat.avail) {
     case MASTER_STAT_AVAIL:
 	proc->use_count++;
+	master_stats_busy(proc, stat.avail);
 	master_avail_more(serv, proc);
 	break;
     case MASTER_STAT_TAKEN:
+	master_stats_busy(proc, stat.avail);
 	master_avail_less(serv, proc);
 	break;
     default:
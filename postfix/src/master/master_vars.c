@@ -49,6 +49,7 @@
 char   *var_inet_protocols;
 int     var_throttle_time;
 char   *var_master_disable;
+int     var_master_stat_time;
 
 /* master_vars_init - initialize from global Postfix configuration file */
 
@@ -61,6 +62,7 @@ void    master_vars_init(void)
     };
     static const CONFIG_TIME_TABLE time_table[] = {
 	VAR_THROTTLE_TIME, DEF_THROTTLE_TIME, &var_throttle_time, 1, 0,
+	VAR_MASTER_STAT_TIME, DEF_MASTER_STAT_TIME, &var_master_stat_time, 0, 0,
 	0,
     };
     static char *saved_inet_protocols;
@@ -182,6 +182,7 @@
 #include <sane_accept.h>
 #include <myflock.h>
 #include <safe_open.h>
+#include <set_cpu_affinity.h>
 #include <listen.h>
 #include <watchdog.h>
 #include <split_at.h>
@@ -425,6 +426,7 @@ NORETURN single_server_main(int argc, char **argv, SINGLE_SERVER_FN service,...)
     char   *lock_path;
     VSTRING *why;
     int     alone = 0;
+    int     excl_wakeup = 1;
     int     zerolimit = 0;
     WATCHDOG *watchdog;
     char   *oname_val;
@@ -715,6 +717,12 @@ NORETURN single_server_main(int argc, char **argv, SINGLE_SERVER_FN service,...)
     single_server_name = service_name;
     single_server_argv = argv + optind;
 
+    /*
+     * Restrict the process to its CPUs before it allocates memory, so that
+     * with the default memory policy that memory is local to those CPUs.
+     */
+    set_cpu_affinity(var_daemon_cpu_affinity);
+
     /*
      * Run pre-jail initialization.
      */
@@ -760,9 +768,22 @@ NORETURN single_server_main(int argc, char **argv, SINGLE_SERVER_FN service,...)
     if (var_idle_limit > 0)
 	event_request_timer(single_server_timeout, (void *) 0, var_idle_limit);
     for (fd = MASTER_LISTEN_FD; fd < MASTER_LISTEN_FD + socket_count; fd++) {
-	event_enable_read(fd, single_server_accept, CAST_INT_TO_VOID_PTR(fd));
+	if (event_enable_read_excl(fd, single_server_accept,
+				   CAST_INT_TO_VOID_PTR(fd)) == 0)
+	    excl_wakeup = 0;
 	close_on_exec(fd, CLOSE_ON_EXEC);
     }
+
+    /*
+     * When the kernel wakes up only one of the processes that wait for a
+     * connection request, the select lock no longer prevents a thundering
+     * herd; it only adds a lock handoff to each connection. Accept errors
+     * are already handled, because the listen sockets are non-blocking.
+     */
+    if (excl_wakeup && single_server_lock != 0) {
+	(void) vstream_fclose(single_server_lock);
+	single_server_lock = 0;
+    }
     event_enable_read(MASTER_STATUS_FD, single_server_abort, (void *) 0);
     close_on_exec(MASTER_STATUS_FD, CLOSE_ON_EXEC);
     close_on_exec(MASTER_FLOW_READ, CLOSE_ON_EXEC);
@@ -35,6 +35,11 @@
 /*	The len argument specifies how much client data is available.
 /*	The maximal size of the buffer is specified via the
 /*	TRIGGER_BUF_SIZE manifest constant.
+/*	A UNIX-domain or stream client that sends TRIGGER_REQ_PERSIST
+/*	as the first byte of a connection keeps the connection open
+/*	for more requests; the skeleton removes that byte before it
+/*	calls the service function, and calls the service function
+/*	again whenever more data arrives on that connection.
 /*	The service name argument corresponds to the service name in the
 /*	master.cf file.
 /*	The argv argument specifies command-line arguments left over
@@ -191,6 +196,7 @@
 #include <sane_accept.h>
 #include <myflock.h>
 #include <safe_open.h>
+#include <set_cpu_affinity.h>
 #include <listen.h>
 #include <watchdog.h>
 #include <split_at.h>
@@ -206,6 +212,7 @@
 #include <mail_flow.h>
 #include <mail_version.h>
 #include <bounce.h>
+#include <mail_proto.h>
 
 /* Process manager. */
 
@@ -260,10 +267,15 @@ static void trigger_server_timeout(int unused_event, void *unused_context)
 
 /* trigger_server_wakeup - wake up application */
 
-static void trigger_server_wakeup(int fd)
+#define TRIGGER_SERVER_FLAG_CONN	(1<<0)	/* new client connection */
+#define TRIGGER_SERVER_FLAG_PERSIST	(1<<1)	/* persistent connection */
+
+static int trigger_server_wakeup(int fd, int flags)
 {
     char    buf[TRIGGER_BUF_SIZE];
+    char   *bp = buf;
     ssize_t len;
+    int     status = 0;
 
     /*
      * Commit suicide when the master process disconnected from us. Don't
@@ -274,9 +286,23 @@ static void trigger_server_wakeup(int fd)
 	 /* void */ ;
     if (trigger_server_in_flow_delay && mail_flow_get(1) < 0)
 	doze(var_in_flow_delay * 1000000);
-    if ((len = read(fd, buf, sizeof(buf))) >= 0)
-	trigger_server_service(buf, len, trigger_server_name,
+    len = read(fd, buf, sizeof(buf));
+    if (flags & TRIGGER_SERVER_FLAG_PERSIST) {
+	if (len == 0 || (len < 0 && errno != EAGAIN))
+	    status = -1;
+	else if (len > 0)
+	    trigger_server_service(buf, len, trigger_server_name,
+				   trigger_server_argv);
+    } else if (len >= 0) {
+	if ((flags & TRIGGER_SERVER_FLAG_CONN) && len > 0
+	    && buf[0] == TRIGGER_REQ_PERSIST) {
+	    bp += 1;
+	    len -= 1;
+	    status = 1;
+	}
+	trigger_server_service(bp, len, trigger_server_name,
 			       trigger_server_argv);
+    }
     if (master_notify(var_pid, trigger_server_generation, MASTER_STAT_AVAIL) < 0)
 	trigger_server_abort(EVENT_NULL_TYPE, EVENT_NULL_CONTEXT);
     if (var_idle_limit > 0)
@@ -284,6 +310,29 @@ static void trigger_server_wakeup(int fd)
     /* Avoid integer wrap-around in a persistent process.  */
     if (use_count < INT_MAX)
 	use_count++;
+    return (status);
+}
+
+/* trigger_server_read_persist - read request from persistent client */
+
+static void trigger_server_read_persist(int unused_event, void *context)
+{
+    int     fd = CAST_ANY_PTR_TO_INT(context);
+
+    /*
+     * The client keeps the connection open, so that it does not have to
+     * connect and disconnect for every request. Requests that arrive while
+     * we are busy are delivered with a single read() call. Disconnect when
+     * the client disconnects.
+     */
+    if (trigger_server_pre_accept)
+	trigger_server_pre_accept(trigger_server_name, trigger_server_argv);
+    if (trigger_server_wakeup(fd, TRIGGER_SERVER_FLAG_PERSIST) < 0) {
+	if (msg_verbose)
+	    msg_info("trigger client disconnected");
+	event_disable_readwrite(fd);
+	(void) close(fd);
+    }
 }
 
 /* trigger_server_accept_fifo - accept fifo client request */
@@ -307,7 +356,7 @@ static void trigger_server_accept_fifo(int unused_event, void *context)
      */
     if (trigger_server_pre_accept)
 	trigger_server_pre_accept(trigger_server_name, trigger_server_argv);
-    trigger_server_wakeup(listen_fd);
+    (void) trigger_server_wakeup(listen_fd, 0);
 }
 
 /* trigger_server_accept_local - accept socket client request */
@@ -347,9 +396,14 @@ static void trigger_server_accept_local(int unused_event, void *context)
 	return;
     }
     close_on_exec(fd, CLOSE_ON_EXEC);
-    if (read_wait(fd, 10) == 0)
-	trigger_server_wakeup(fd);
-    else if (time_left >= 0)
+    if (read_wait(fd, 10) == 0) {
+	if (trigger_server_wakeup(fd, TRIGGER_SERVER_FLAG_CONN) > 0) {
+	    non_blocking(fd, NON_BLOCKING);
+	    event_enable_read(fd, trigger_server_read_persist,
+			      CAST_INT_TO_VOID_PTR(fd));
+	    return;
+	}
+    } else if (time_left >= 0)
 	event_request_timer(trigger_server_timeout, (void *) 0, time_left);
     close(fd);
 }
@@ -393,9 +447,14 @@ static void trigger_server_accept_pass(int unused_event, void *context)
 	return;
     }
     close_on_exec(fd, CLOSE_ON_EXEC);
-    if (read_wait(fd, 10) == 0)
-	trigger_server_wakeup(fd);
-    else if (time_left >= 0)
+    if (read_wait(fd, 10) == 0) {
+	if (trigger_server_wakeup(fd, TRIGGER_SERVER_FLAG_CONN) > 0) {
+	    non_blocking(fd, NON_BLOCKING);
+	    event_enable_read(fd, trigger_server_read_persist,
+			      CAST_INT_TO_VOID_PTR(fd));
+	    return;
+	}
+    } else if (time_left >= 0)
 	event_request_timer(trigger_server_timeout, (void *) 0, time_left);
     close(fd);
 }
@@ -735,6 +794,12 @@ NORETURN trigger_server_main(int argc, char **argv, TRIGGER_SERVER_FN service,..
     trigger_server_name = service_name;
     trigger_server_argv = argv + optind;
 
+    /*
+     * Restrict the process to its CPUs before it allocates memory, so that
+     * with the default memory policy that memory is local to those CPUs.
+     */
+    set_cpu_affinity(var_daemon_cpu_affinity);
+
     /*
      * Run pre-jail initialization.
      */
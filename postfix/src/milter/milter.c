@@ -317,9 +317,18 @@ HTABLE *milter_macro_defaults_create(const char *macro_defaults)
     return (table);
 }
 
+/* milter_macro_free - destroy cached macro value */
+
+static void milter_macro_free(void *ptr)
+{
+    if (ptr != 0)
+	myfree(ptr);
+}
+
 /* milter_macro_lookup - look up macros */
 
-static ARGV *milter_macro_lookup(MILTERS *milters, const char *macro_names)
+static ARGV *milter_macro_lookup(MILTERS *milters, const char *macro_names,
+				         HTABLE **cache)
 {
     const char *myname = "milter_macro_lookup";
     char   *saved_names = mystrdup(macro_names);
@@ -328,15 +337,33 @@ static ARGV *milter_macro_lookup(MILTERS *milters, const char *macro_names)
     VSTRING *canon_buf = vstring_alloc(20);
     const char *value;
     const char *name;
+    HTABLE_INFO *ht;
+
+    /*
+     * When milters have their own macro lists, the same macro names tend to
+     * show up in several lists for the same event. Evaluate each name only
+     * once per event, including names that have no value.
+     */
+    if (*cache == 0)
+	*cache = htable_create(10);
 
     while ((name = mystrtok(&cp, CHARS_COMMA_SP)) != 0) {
 	if (msg_verbose)
 	    msg_info("%s: \"%s\"", myname, name);
 	if (*name != '{')			/* } */
 	    name = STR(vstring_sprintf(canon_buf, "{%s}", name));
-	if ((value = milters->mac_lookup(name, milters->mac_context)) != 0) {
+	if ((ht = htable_locate(*cache, name)) != 0) {
+	    value = ht->value;
 	    if (msg_verbose)
+		msg_info("%s: cached result \"%s\"", myname,
+			 value ? value : "(none)");
+	} else {
+	    value = milters->mac_lookup(name, milters->mac_context);
+	    (void) htable_enter(*cache, name, value ? mystrdup(value) : 0);
+	    if (msg_verbose && value != 0)
 		msg_info("%s: result \"%s\"", myname, value);
+	}
+	if (value != 0) {
 	    argv_add(argv, name, value, (char *) 0);
 	} else if (milters->macro_defaults != 0
 	     && (value = htable_find(milters->macro_defaults, name)) != 0) {
@@ -398,13 +425,15 @@ const char *milter_conn_event(MILTERS *milters,
     MILTER *m;
     ARGV   *global_macros = 0;
     ARGV   *any_macros;
+    HTABLE *macro_cache = 0;
 
 #define MILTER_MACRO_EVAL(global_macros, m, milters, member) \
 	((m->macros && m->macros->member[0]) ? \
-	    milter_macro_lookup(milters, m->macros->member) : \
+	    milter_macro_lookup(milters, m->macros->member, &macro_cache) : \
 		global_macros ? global_macros : \
 		    (global_macros = \
-		         milter_macro_lookup(milters, milters->macros->member)))
+		         milter_macro_lookup(milters, milters->macros->member, \
+					     &macro_cache)))
 
     if (msg_verbose)
 	msg_info("report connect to all milters");
@@ -417,6 +446,8 @@ const char *milter_conn_event(MILTERS *milters,
     }
     if (global_macros)
 	argv_free(global_macros);
+    if (macro_cache)
+	htable_free(macro_cache, milter_macro_free);
     return (resp);
 }
 
@@ -429,6 +460,7 @@ const char *milter_helo_event(MILTERS *milters, const char *helo_name,
     MILTER *m;
     ARGV   *global_macros = 0;
     ARGV   *any_macros;
+    HTABLE *macro_cache = 0;
 
     if (msg_verbose)
 	msg_info("report helo to all milters");
@@ -440,6 +472,8 @@ const char *milter_helo_event(MILTERS *milters, const char *helo_name,
     }
     if (global_macros)
 	argv_free(global_macros);
+    if (macro_cache)
+	htable_free(macro_cache, milter_macro_free);
     return (resp);
 }
 
@@ -451,6 +485,7 @@ const char *milter_mail_event(MILTERS *milters, const char **argv)
     MILTER *m;
     ARGV   *global_macros = 0;
     ARGV   *any_macros;
+    HTABLE *macro_cache = 0;
 
     if (msg_verbose)
 	msg_info("report sender to all milters");
@@ -462,6 +497,8 @@ const char *milter_mail_event(MILTERS *milters, const char **argv)
     }
     if (global_macros)
 	argv_free(global_macros);
+    if (macro_cache)
+	htable_free(macro_cache, milter_macro_free);
     return (resp);
 }
 
@@ -473,6 +510,7 @@ const char *milter_rcpt_event(MILTERS *milters, int flags, const char **argv)
     MILTER *m;
     ARGV   *global_macros = 0;
     ARGV   *any_macros;
+    HTABLE *macro_cache = 0;
 
     if (msg_verbose)
 	msg_info("report recipient to all milters (flags=0x%x)", flags);
@@ -488,6 +526,8 @@ const char *milter_rcpt_event(MILTERS *milters, int flags, const char **argv)
     }
     if (global_macros)
 	argv_free(global_macros);
+    if (macro_cache)
+	htable_free(macro_cache, milter_macro_free);
     return (resp);
 }
 
@@ -499,6 +539,7 @@ const char *milter_data_event(MILTERS *milters)
     MILTER *m;
     ARGV   *global_macros = 0;
     ARGV   *any_macros;
+    HTABLE *macro_cache = 0;
 
     if (msg_verbose)
 	msg_info("report data to all milters");
@@ -510,6 +551,8 @@ const char *milter_data_event(MILTERS *milters)
     }
     if (global_macros)
 	argv_free(global_macros);
+    if (macro_cache)
+	htable_free(macro_cache, milter_macro_free);
     return (resp);
 }
 
@@ -521,6 +564,7 @@ const char *milter_unknown_event(MILTERS *milters, const char *command)
     MILTER *m;
     ARGV   *global_macros = 0;
     ARGV   *any_macros;
+    HTABLE *macro_cache = 0;
 
     if (msg_verbose)
 	msg_info("report unknown command to all milters");
@@ -532,6 +576,8 @@ const char *milter_unknown_event(MILTERS *milters, const char *command)
     }
     if (global_macros)
 	argv_free(global_macros);
+    if (macro_cache)
+	htable_free(macro_cache, milter_macro_free);
     return (resp);
 }
 
@@ -560,6 +606,7 @@ const char *milter_message(MILTERS *milters, VSTREAM *fp, off_t data_offset,
     ARGV   *global_eod_macros = 0;
     ARGV   *any_eoh_macros;
     ARGV   *any_eod_macros;
+    HTABLE *macro_cache = 0;
 
     if (msg_verbose)
 	msg_info("inspect content by all milters");
@@ -572,11 +619,18 @@ const char *milter_message(MILTERS *milters, VSTREAM *fp, off_t data_offset,
 	    argv_free(any_eoh_macros);
 	if (any_eod_macros != global_eod_macros)
 	    argv_free(any_eod_macros);
+	/* A milter may have changed the message. Don't reuse its macros. */
+	if (macro_cache) {
+	    htable_free(macro_cache, milter_macro_free);
+	    macro_cache = 0;
+	}
     }
     if (global_eoh_macros)
 	argv_free(global_eoh_macros);
     if (global_eod_macros)
 	argv_free(global_eod_macros);
+    if (macro_cache)
+	htable_free(macro_cache, milter_macro_free);
     return (resp);
 }
 
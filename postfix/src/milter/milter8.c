@@ -85,6 +85,7 @@
 #include <name_code.h>
 #include <stringops.h>
 #include <compat_va_copy.h>
+#include <iostuff.h>
 
 /* Global library. */
 
@@ -381,6 +382,15 @@ typedef struct {
   */
 #define LIBMILTER_AUTO_DISCONNECT
 
+ /*
+  * Milter protocol version 6 allows us to end a session with SMFIC_QUIT_NC
+  * instead of SMFIC_QUIT. The Milter application then keeps the socket open
+  * and waits for the CONNECT event of the next SMTP session, without another
+  * round of option negotiation.
+  */
+#define MILTER8_CONN_REUSE(milter) \
+	(var_milt_conn_reuse && (milter)->version >= 6)
+
  /*
   * Milter internal state. For the external representation we use SMTP
   * replies (4XX X.Y.Z text, 5XX X.Y.Z text) and one-letter strings
@@ -1921,7 +1931,19 @@ static const char *milter8_conn_event(MILTER *m,
      * has to open a new MTA-to-filter socket for each SMTP client.
      */
 #ifdef LIBMILTER_AUTO_DISCONNECT
-    milter8_connect(milter);
+    if (milter->fp != 0 && milter->state == MILTER8_STAT_READY
+	&& vstream_peek(milter->fp) == 0
+	&& readable(vstream_fileno(milter->fp)) == 0) {
+	if (msg_verbose)
+	    msg_info("%s: reuse connection to milter %s",
+		     myname, milter->m.name);
+	milter->skip_event_type = 0;
+    } else {
+	/* The Milter application closed an idle connection. */
+	if (milter->fp != 0)
+	    milter8_close_stream(milter);
+	milter8_connect(milter);
+    }
 #endif
 
     /*
@@ -2268,6 +2290,21 @@ static void milter8_disc_event(MILTER *m)
     case MILTER8_STAT_REJECT_CON:
 #endif
     case MILTER8_STAT_ACCEPT_MSG:
+#ifdef LIBMILTER_AUTO_DISCONNECT
+	if (MILTER8_CONN_REUSE(milter)) {
+	    if (msg_verbose)
+		msg_info("%s: quit milter %s, keep connection",
+			 myname, milter->m.name);
+	    if (milter8_write_cmd(milter, SMFIC_QUIT_NC,
+				  MILTER8_DATA_END) == 0
+		&& vstream_fflush(milter->fp) == 0) {
+		milter->state = MILTER8_STAT_READY;
+		milter8_def_reply(milter, 0);
+		return;
+	    }
+	    break;
+	}
+#endif
 	if (msg_verbose)
 	    msg_info("%s: quit milter %s", myname, milter->m.name);
 	(void) milter8_write_cmd(milter, SMFIC_QUIT, MILTER8_DATA_END);
@@ -5,7 +5,7 @@
 /*	Postfix alias database maintenance
 /* SYNOPSIS
 /* .fi
-/*	\fBpostalias\fR [\fB-Nfinoprsuvw\fR] [\fB-c \fIconfig_dir\fR]
+/*	\fBpostalias\fR [\fB-ANfinoprsuvw\fR] [\fB-c \fIconfig_dir\fR]
 /*	[\fB-d \fIkey\fR] [\fB-q \fIkey\fR]
 /*		[\fIfile_type\fR:]\fIfile_name\fR ...
 /* DESCRIPTION
@@ -34,7 +34,23 @@
 /*	text, such as regexp: and pcre:. This resulted in loss of
 /*	information with $\fInumber\fR substitutions.
 /*
+/*	When creating a database, \fBpostalias\fR(1) reads the entire
+/*	input file into memory, discards duplicate entries, and
+/*	writes the remaining entries in sorted key order. This
+/*	reduces the time that the database is locked, and speeds
+/*	up the creation of btree, cdb and lmdb files.
+/*
 /*	Options:
+/* .IP \fB-A\fR
+/*	Atomic update. Create the new database under a temporary
+/*	name, and rename it to the final name when it is complete.
+/*	Spectator processes such as \fBlocal\fR(8) keep using the
+/*	old database while the new one is being created, instead
+/*	of waiting for the exclusive lock. This option is
+/*	supported only when creating btree, cdb, hash or lmdb
+/*	files (cdb files are always created this way).
+/*
+/*	This feature is available in Postfix 3.1 and later.
 /* .IP "\fB-c \fIconfig_dir\fR"
 /*	Read the \fBmain.cf\fR configuration file in the named directory
 /*	instead of the default configuration directory.
@@ -223,9 +239,11 @@
 #include <sys/stat.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <ctype.h>
 #include <string.h>
+#include <stdio.h>			/* rename() */
 
 /* Utility library. */
 
@@ -241,6 +259,7 @@
 #include <vstring_vstream.h>
 #include <set_eugid.h>
 #include <warn_stat.h>
+#include <htable.h>
 
 /* Global library. */
 
@@ -261,6 +280,67 @@
 #define POSTALIAS_FLAG_AS_OWNER	(1<<0)	/* open dest as owner of source */
 #define POSTALIAS_FLAG_SAVE_PERM	(1<<1)	/* copy access permission
 						 * from source */
+#define POSTALIAS_FLAG_ATOMIC	(1<<2)	/* create under temporary name */
+
+ /*
+  * Database types that can be created under a temporary name and then
+  * renamed, with the suffix that the dict(3) layer appends to the pathname.
+  * A null suffix means that the dict(3) layer already does this by itself.
+  */
+typedef struct {
+    const char *type;			/* database type */
+    const char *suffix;			/* file name suffix */
+} POSTALIAS_SWAP;
+
+static const POSTALIAS_SWAP postalias_swap[] = {
+    {"btree", ".db"},
+    {"hash", ".db"},
+    {"lmdb", ".lmdb"},
+    {"cdb", 0},
+    {0, 0},
+};
+
+ /*
+  * The temporary name includes the process ID, so that concurrent postalias
+  * processes don't clobber each other's file after the lock is released.
+  */
+#define POSTALIAS_TMP_SUFFIX	".tmp"
+#define POSTALIAS_LOCK_SUFFIX	"-lock"	/* LMDB lock file, if any */
+
+/* postalias_stage - save entry in memory, enforce duplicate policy */
+
+static void postalias_stage(HTABLE *table, VSTRING *fold_buf, int dict_flags,
+			            const char *key, const char *value,
+			            const char *path, int lineno)
+{
+    HTABLE_INFO *ht;
+
+    /*
+     * Fold the key the same way as the dict(3) layer would, so that we find
+     * the same duplicates.
+     */
+    if (dict_flags & DICT_FLAG_FOLD_FIX)
+	key = casefold(fold_buf, key);
+    if ((ht = htable_locate(table, key)) == 0) {
+	(void) htable_enter(table, key, mystrdup(value));
+    } else if (dict_flags & DICT_FLAG_DUP_REPLACE) {
+	myfree(ht->value);
+	ht->value = mystrdup(value);
+    } else if (dict_flags & DICT_FLAG_DUP_IGNORE) {
+	 /* void */ ;
+    } else if (dict_flags & DICT_FLAG_DUP_WARN) {
+	msg_warn("%s, line %d: duplicate entry: \"%s\"", path, lineno, key);
+    } else {
+	msg_fatal("%s, line %d: duplicate entry: \"%s\"", path, lineno, key);
+    }
+}
+
+/* postalias_compare - qsort callback */
+
+static int postalias_compare(const void *a, const void *b)
+{
+    return (strcmp((*(HTABLE_INFO **) a)->key, (*(HTABLE_INFO **) b)->key));
+}
 
 /* postalias - create or update alias database */
 
@@ -280,6 +360,12 @@ static void postalias(char *map_type, char *path_name, int postalias_flags,
     TOK822 *value_list;
     struct stat st;
     mode_t  saved_mask;
+    HTABLE *staging = 0;
+    HTABLE_INFO **list;
+    HTABLE_INFO **ht;
+    VSTRING *fold_buf = 0;
+    const POSTALIAS_SWAP *sp = 0;
+    char   *db_name = path_name;
 
     /*
      * Initialize.
@@ -298,6 +384,31 @@ static void postalias(char *map_type, char *path_name, int postalias_flags,
 	dict_flags |= DICT_FLAG_BULK_UPDATE;
 	if ((source_fp = vstream_fopen(path_name, O_RDONLY, 0)) == 0)
 	    msg_fatal("open %s: %m", path_name);
+	staging = htable_create(1024);
+	fold_buf = vstring_alloc(100);
+    }
+
+    /*
+     * Create the database under a temporary name, so that spectators can
+     * keep using the old one until we are done.
+     */
+    if (postalias_flags & POSTALIAS_FLAG_ATOMIC) {
+	if ((open_flags & O_TRUNC) == 0)
+	    msg_fatal("atomic update requires database creation mode");
+	for (sp = postalias_swap; /* see below */ ; sp++) {
+	    if (sp->type == 0)
+		msg_fatal("atomic update is not supported for table type: %s",
+			  map_type);
+	    if (strcmp(sp->type, map_type) == 0)
+		break;
+	}
+	if (sp->suffix != 0) {
+	    VSTRING *tmp_buf = vstring_alloc(100);
+
+	    vstring_sprintf(tmp_buf, "%s%s.%ld", path_name,
+			    POSTALIAS_TMP_SUFFIX, (long) getpid());
+	    db_name = vstring_export(tmp_buf);
+	}
     }
     if (fstat(vstream_fileno(source_fp), &st) < 0)
 	msg_fatal("fstat %s: %m", path_name);
@@ -321,7 +432,7 @@ static void postalias(char *map_type, char *path_name, int postalias_flags,
      * Open the database, create it when it does not exist, truncate it when
      * it does exist, and lock out any spectators.
      */
-    mkmap = mkmap_open(map_type, path_name, open_flags, dict_flags);
+    mkmap = mkmap_open(map_type, db_name, open_flags, dict_flags);
 
     /*
      * And restore the umask, in case it matters.
@@ -413,8 +524,15 @@ static void postalias(char *map_type, char *path_name, int postalias_flags,
 	    tok822_free_tree(value_list);
 
 	    /*
-	     * Store the value under a case-insensitive key.
+	     * Store the value under a case-insensitive key. When creating a
+	     * database, save the entry in memory and write it later.
 	     */
+	    if (staging) {
+		postalias_stage(staging, fold_buf, mkmap->dict->flags,
+				STR(key_buffer), STR(value_buffer),
+				VSTREAM_PATH(source_fp), lineno);
+		continue;
+	    }
 	    mkmap_append(mkmap, STR(key_buffer), STR(value_buffer));
 	    if (mkmap->dict->error)
 		msg_fatal("table %s:%s: write error: %m",
@@ -423,6 +541,33 @@ static void postalias(char *map_type, char *path_name, int postalias_flags,
 	break;
     }
 
+    /*
+     * Write the saved entries in sorted key order. Duplicates were already
+     * eliminated, and sorted input is faster for btree, cdb and lmdb files.
+     * After a recoverable error, start over with the first entry.
+     */
+    if (staging) {
+	list = htable_list(staging);
+	qsort((void *) list, staging->used, sizeof(*list), postalias_compare);
+	for (;;) {
+	    if (dict_isjmp(mkmap->dict) != 0
+		&& dict_setjmp(mkmap->dict) != 0
+		&& msg_verbose)
+		msg_info("restarting bulk update of %s:%s",
+			 mkmap->dict->type, mkmap->dict->name);
+	    for (ht = list; *ht; ht++) {
+		mkmap_append(mkmap, ht[0]->key, (char *) ht[0]->value);
+		if (mkmap->dict->error)
+		    msg_fatal("table %s:%s: write error: %m",
+			      mkmap->dict->type, mkmap->dict->name);
+	    }
+	    break;
+	}
+	myfree((void *) list);
+	htable_free(staging, myfree);
+	vstring_free(fold_buf);
+    }
+
     /*
      * Update or append sendmail and NIS signatures.
      */
@@ -458,6 +603,25 @@ static void postalias(char *map_type, char *path_name, int postalias_flags,
      */
     mkmap_close(mkmap);
 
+    /*
+     * Replace the old database with the new one.
+     */
+    if (db_name != path_name) {
+	char   *tmp_path = concatenate(db_name, sp->suffix, (char *) 0);
+	char   *new_path = concatenate(path_name, sp->suffix, (char *) 0);
+	char   *lock_path;
+
+	if (rename(tmp_path, new_path) < 0)
+	    msg_fatal("rename %s to %s: %m", tmp_path, new_path);
+	lock_path = concatenate(tmp_path, POSTALIAS_LOCK_SUFFIX, (char *) 0);
+	if (unlink(lock_path) < 0 && errno != ENOENT)
+	    msg_warn("remove %s: %m", lock_path);
+	myfree(lock_path);
+	myfree(new_path);
+	myfree(tmp_path);
+	myfree(db_name);
+    }
+
     /*
      * Cleanup. We're about to terminate, but it is a good sanity check.
      */
@@ -674,7 +838,7 @@ static void postalias_seq(const char *map_type, const char *map_name,
 
 static NORETURN usage(char *myname)
 {
-    msg_fatal("usage: %s [-Nfinoprsuvw] [-c config_dir] [-d key] [-q key] [map_type:]file...",
+    msg_fatal("usage: %s [-ANfinoprsuvw] [-c config_dir] [-d key] [-q key] [map_type:]file...",
 	      myname);
 }
 
@@ -740,11 +904,14 @@ int     main(int argc, char **argv)
     /*
      * Parse JCL.
      */
-    while ((ch = GETOPT(argc, argv, "Nc:d:finopq:rsuvw")) > 0) {
+    while ((ch = GETOPT(argc, argv, "ANc:d:finopq:rsuvw")) > 0) {
 	switch (ch) {
 	default:
 	    usage(argv[0]);
 	    break;
+	case 'A':
+	    postalias_flags |= POSTALIAS_FLAG_ATOMIC;
+	    break;
 	case 'N':
 	    dict_flags |= DICT_FLAG_TRY1NULL;
 	    dict_flags &= ~DICT_FLAG_TRY0NULL;
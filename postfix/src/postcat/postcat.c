@@ -4,7 +4,7 @@
 /* SUMMARY
 /*	show Postfix queue file contents
 /* SYNOPSIS
-/*	\fBpostcat\fR [\fB-bdehnoqv\fR] [\fB-c \fIconfig_dir\fR] [\fIfiles\fR...]
+/*	\fBpostcat\fR [\fB-bdehnoqtv\fR] [\fB-c \fIconfig_dir\fR] [\fIfiles\fR...]
 /* DESCRIPTION
 /*	The \fBpostcat\fR(1) command prints the contents of the
 /*	named \fIfiles\fR in human-readable form. The files are
@@ -17,6 +17,16 @@
 /*	view message content only, specify \fB-bh\fR (Postfix 2.7
 /*	and later).
 /*
+/*	With seekable input, \fBpostcat\fR(1) uses the size record
+/*	at the start of a queue file to jump directly to the message
+/*	content or to the extracted envelope records, instead of
+/*	reading the parts of the file that are not shown.
+/*
+/*	A file name of \fB-\fR causes \fBpostcat\fR(1) to read
+/*	file names (or queue IDs, with \fB-q\fR) from standard input,
+/*	one per line (Postfix 3.1 and later). This can be used to
+/*	inspect many queue files with one \fBpostcat\fR(1) process.
+/*
 /*	Options:
 /* .IP \fB-b\fR
 /*	Show body content.  The \fB-b\fR option starts producing
@@ -46,6 +56,11 @@
 /*	of taking the names literally.
 /*
 /*	This feature is available in Postfix 2.0 and later.
+/* .IP \fB-t\fR
+/*	Report the time spent on each file to the standard error
+/*	stream.
+/* .sp
+/*	This feature is available in Postfix 3.1 and later.
 /* .IP \fB-v\fR
 /*	Enable verbose logging for debugging purposes. Multiple \fB-v\fR
 /*	options make the software increasingly verbose.
@@ -117,6 +132,7 @@
 #include <mail_proto.h>
 #include <is_header.h>
 #include <lex_822.h>
+#include <rec_index.h>
 
 /* Application-specific. */
 
@@ -127,6 +143,7 @@
 #define PC_FLAG_PRINT_BODY	(1<<4)	/* print body records */
 #define PC_FLAG_PRINT_RTYPE_DEC	(1<<5)	/* print decimal record type */
 #define PC_FLAG_PRINT_RTYPE_SYM	(1<<6)	/* print symbolic record type */
+#define PC_FLAG_PRINT_TIME	(1<<7)	/* print per-file timing */
 
 #define PC_MASK_PRINT_TEXT	(PC_FLAG_PRINT_HEADER | PC_FLAG_PRINT_BODY)
 #define PC_MASK_PRINT_ALL	(PC_FLAG_PRINT_ENV | PC_MASK_PRINT_TEXT)
@@ -143,7 +160,7 @@
 
 /* postcat - visualize Postfix queue file contents */
 
-static void postcat(VSTREAM *fp, VSTRING *buffer, int flags)
+static int postcat(VSTREAM *fp, VSTRING *buffer, int flags)
 {
     int     prev_type = 0;
     int     rec_type;
@@ -157,8 +174,8 @@ static void postcat(VSTREAM *fp, VSTRING *buffer, int flags)
     int     rec_flags = (msg_verbose ? REC_FLAG_NONE : REC_FLAG_DEFAULT);
     int     state;			/* state machine, input type */
     int     do_print;			/* state machine, output control */
-    long    data_offset;		/* state machine, read optimization */
-    long    data_size;			/* state machine, read optimization */
+    REC_INDEX index;			/* state machine, read optimization */
+    int     size_seen = 0;
 
 #define TEXT_RECORD(rec_type) \
 	    (rec_type == REC_TYPE_CONT || rec_type == REC_TYPE_NORM)
@@ -169,11 +186,19 @@ static void postcat(VSTREAM *fp, VSTRING *buffer, int flags)
     if ((ch = VSTREAM_GETC(fp)) != VSTREAM_EOF) {
 	if (!strchr(REC_TYPE_ENVELOPE, ch)) {
 	    msg_warn("%s: input is not a valid queue file", VSTREAM_PATH(fp));
-	    return;
+	    return (0);
 	}
 	vstream_ungetc(fp, ch);
     }
 
+    /*
+     * Find out where the message content and the extracted envelope start.
+     * This works only with seekable input. A malformed size record is an
+     * error; the caller decides if it is fatal.
+     */
+    if (rec_index_init(&index, fp, rec_flags) == REC_TYPE_ERROR)
+	return (-1);
+
     /*
      * Other preliminaries.
      */
@@ -182,7 +207,15 @@ static void postcat(VSTREAM *fp, VSTRING *buffer, int flags)
 		       VSTREAM_PATH(fp));
     state = PC_STATE_ENV;
     do_print = (flags & PC_FLAG_PRINT_ENV);
-    data_offset = data_size = -1;
+
+    /*
+     * Optimization: skip the envelope if we don't need to print it.
+     */
+    if ((flags & PC_FLAG_PRINT_ENV) == 0
+	&& rec_index_seek(&index, fp, REC_INDEX_SECT_CONTENT) == 0) {
+	state = PC_STATE_HEADER;
+	do_print = (flags & PC_FLAG_PRINT_HEADER);
+    }
 
     /*
      * Now look at the rest.
@@ -235,8 +268,8 @@ static void postcat(VSTREAM *fp, VSTRING *buffer, int flags)
 		    break;
 		/* Optimization: skip to extracted segment marker. */
 		if (do_print == 0 && (flags & PC_FLAG_PRINT_ENV)
-		    && data_offset >= 0 && data_size >= 0
-		&& vstream_fseek(fp, data_offset + data_size, SEEK_SET) < 0)
+		    && REC_INDEX_OK(&index)
+		    && rec_index_seek(&index, fp, REC_INDEX_SECT_XTRA) < 0)
 		    msg_fatal("seek error: %m");
 	    }
 	    /* Optional output happens further down below. */
@@ -250,8 +283,8 @@ static void postcat(VSTREAM *fp, VSTRING *buffer, int flags)
 		PRINT_MARKER(flags, fp, offset, rec_type, "MESSAGE CONTENTS");
 	    /* Optimization: skip to extracted segment marker. */
 	    if ((flags & PC_MASK_PRINT_TEXT) == 0
-		&& data_offset >= 0 && data_size >= 0
-		&& vstream_fseek(fp, data_offset + data_size, SEEK_SET) < 0)
+		&& REC_INDEX_OK(&index)
+		&& rec_index_seek(&index, fp, REC_INDEX_SECT_XTRA) < 0)
 		msg_fatal("seek error: %m");
 	    /* Update the state machine, even when skipping. */
 	    state = PC_STATE_HEADER;
@@ -297,22 +330,9 @@ static void postcat(VSTREAM *fp, VSTRING *buffer, int flags)
 	    /* Optional output (here before we update the state machine). */
 	    if (do_print)
 		PRINT_RECORD(flags, offset, rec_type, STR(buffer));
-	    /* Read the message size/offset for the state machine optimizer. */
-	    if (data_size >= 0 || data_offset >= 0) {
+	    /* The message size/offset were read by rec_index_init(). */
+	    if (size_seen++ > 0)
 		msg_warn("file contains multiple size records");
-	    } else {
-		if (sscanf(STR(buffer), "%ld %ld", &data_size, &data_offset) != 2
-		    || data_offset <= 0 || data_size <= 0)
-		    msg_fatal("invalid size record: %.100s", STR(buffer));
-		/* Optimization: skip to the message header. */
-		if ((flags & PC_FLAG_PRINT_ENV) == 0) {
-		    if (vstream_fseek(fp, data_offset, SEEK_SET) < 0)
-			msg_fatal("seek error: %m");
-		    /* Update the state machine. */
-		    state = PC_STATE_HEADER;
-		    do_print = (flags & PC_FLAG_PRINT_HEADER);
-		}
-	    }
 	    continue;
 	}
 
@@ -388,13 +408,72 @@ static void postcat(VSTREAM *fp, VSTRING *buffer, int flags)
 	 */
 	vstream_fflush(VSTREAM_OUT);
     }
+    return (0);
+}
+
+/* postcat_name - show contents of named file or queue file */
+
+static void postcat_name(const char *name, VSTRING *buffer, int flags,
+			         int batch)
+{
+    static char *queue_names[] = {
+	MAIL_QUEUE_MAILDROP,
+	MAIL_QUEUE_INCOMING,
+	MAIL_QUEUE_ACTIVE,
+	MAIL_QUEUE_DEFERRED,
+	MAIL_QUEUE_HOLD,
+	MAIL_QUEUE_SAVED,
+	0,
+    };
+    char  **cpp;
+    int     tries;
+    VSTREAM *fp;
+    struct timeval start;
+    struct timeval finish;
+
+    /*
+     * When names come from standard input, don't give up the whole batch
+     * because one queue file went away or is damaged.
+     */
+#define PC_ERROR(batch) ((batch) ? msg_warn : msg_fatal)
+
+    if (flags & PC_FLAG_PRINT_TIME)
+	GETTIMEOFDAY(&start);
+    if (flags & PC_FLAG_SEARCH_QUEUE) {
+	if (!mail_queue_id_ok(name)) {
+	    PC_ERROR(batch) ("bad mail queue ID: %s", name);
+	    return;
+	}
+	for (fp = 0, tries = 0; fp == 0 && tries < 2; tries++)
+	    for (cpp = queue_names; fp == 0 && *cpp != 0; cpp++)
+		fp = mail_queue_open(*cpp, name, O_RDONLY, 0);
+	if (fp == 0) {
+	    PC_ERROR(batch) ("open queue file %s: %m", name);
+	    return;
+	}
+    } else {
+	if ((fp = vstream_fopen(name, O_RDONLY, 0)) == 0) {
+	    PC_ERROR(batch) ("open %s: %m", name);
+	    return;
+	}
+    }
+    if (postcat(fp, buffer, flags) < 0)
+	PC_ERROR(batch) ("%s: input is not a valid queue file", name);
+    if (vstream_fclose(fp))
+	msg_warn("close %s: %m", name);
+    if (flags & PC_FLAG_PRINT_TIME) {
+	GETTIMEOFDAY(&finish);
+	msg_info("%s: %.3f ms", name,
+		 (finish.tv_sec - start.tv_sec) * 1000.0
+		 + (finish.tv_usec - start.tv_usec) / 1000.0);
+    }
 }
 
 /* usage - explain and terminate */
 
 static NORETURN usage(char *myname)
 {
-    msg_fatal("usage: %s [-b (body text)] [-c config_dir] [-d (decimal record type)] [-e (envelope records)] [-h (header text)] [-q (access queue)] [-v] [file(s)...]",
+    msg_fatal("usage: %s [-b (body text)] [-c config_dir] [-d (decimal record type)] [-e (envelope records)] [-h (header text)] [-q (access queue)] [-t (timing)] [-v] [file(s)...]",
 	      myname);
 }
 
@@ -403,22 +482,11 @@ MAIL_VERSION_STAMP_DECLARE;
 int     main(int argc, char **argv)
 {
     VSTRING *buffer;
-    VSTREAM *fp;
     int     ch;
     int     fd;
     struct stat st;
     int     flags = 0;
-    static char *queue_names[] = {
-	MAIL_QUEUE_MAILDROP,
-	MAIL_QUEUE_INCOMING,
-	MAIL_QUEUE_ACTIVE,
-	MAIL_QUEUE_DEFERRED,
-	MAIL_QUEUE_HOLD,
-	MAIL_QUEUE_SAVED,
-	0,
-    };
-    char  **cpp;
-    int     tries;
+    VSTRING *name_buf;
 
     /*
      * Fingerprint executables and core dumps.
@@ -443,7 +511,7 @@ int     main(int argc, char **argv)
     /*
      * Parse JCL.
      */
-    while ((ch = GETOPT(argc, argv, "bc:dehoqv")) > 0) {
+    while ((ch = GETOPT(argc, argv, "bc:dehoqtv")) > 0) {
 	switch (ch) {
 	case 'b':
 	    flags |= PC_FLAG_PRINT_BODY;
@@ -467,6 +535,9 @@ int     main(int argc, char **argv)
 	case 'q':
 	    flags |= PC_FLAG_SEARCH_QUEUE;
 	    break;
+	case 't':
+	    flags |= PC_FLAG_PRINT_TIME;
+	    break;
 	case 'v':
 	    msg_verbose++;
 	    break;
@@ -494,40 +565,28 @@ int     main(int argc, char **argv)
 	vstream_control(VSTREAM_IN,
 			CA_VSTREAM_CTL_PATH("stdin"),
 			CA_VSTREAM_CTL_END);
-	postcat(VSTREAM_IN, buffer, flags);
-    }
-
-    /*
-     * Copy the named queue files in the specified order.
-     */
-    else if (flags & PC_FLAG_SEARCH_QUEUE) {
-	if (chdir(var_queue_dir))
-	    msg_fatal("chdir %s: %m", var_queue_dir);
-	while (optind < argc) {
-	    if (!mail_queue_id_ok(argv[optind]))
-		msg_fatal("bad mail queue ID: %s", argv[optind]);
-	    for (fp = 0, tries = 0; fp == 0 && tries < 2; tries++)
-		for (cpp = queue_names; fp == 0 && *cpp != 0; cpp++)
-		    fp = mail_queue_open(*cpp, argv[optind], O_RDONLY, 0);
-	    if (fp == 0)
-		msg_fatal("open queue file %s: %m", argv[optind]);
-	    postcat(fp, buffer, flags);
-	    if (vstream_fclose(fp))
-		msg_warn("close %s: %m", argv[optind]);
-	    optind++;
-	}
+	if (postcat(VSTREAM_IN, buffer, flags) < 0)
+	    msg_fatal("stdin: input is not a valid queue file");
     }
 
     /*
-     * Copy the named files in the specified order.
+     * Copy the named (queue) files in the specified order. The name "-"
+     * means read names from stdin, so that one process can handle a large
+     * batch of files.
      */
     else {
+	if ((flags & PC_FLAG_SEARCH_QUEUE) && chdir(var_queue_dir))
+	    msg_fatal("chdir %s: %m", var_queue_dir);
 	while (optind < argc) {
-	    if ((fp = vstream_fopen(argv[optind], O_RDONLY, 0)) == 0)
-		msg_fatal("open %s: %m", argv[optind]);
-	    postcat(fp, buffer, flags);
-	    if (vstream_fclose(fp))
-		msg_warn("close %s: %m", argv[optind]);
+	    if (strcmp(argv[optind], "-") == 0) {
+		name_buf = vstring_alloc(100);
+		while (vstring_get_nonl(name_buf, VSTREAM_IN) != VSTREAM_EOF)
+		    if (LEN(name_buf) > 0)
+			postcat_name(STR(name_buf), buffer, flags, 1);
+		vstring_free(name_buf);
+	    } else {
+		postcat_name(argv[optind], buffer, flags, 0);
+	    }
 	    optind++;
 	}
     }
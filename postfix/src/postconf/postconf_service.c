@@ -135,6 +135,7 @@ void    pcf_register_service_parameters(void)
 	_CONC_COHORT_LIM, VAR_CONC_COHORT_LIM,
 	_DEST_RATE_DELAY, VAR_DEST_RATE_DELAY,
 	_XPORT_RATE_DELAY, VAR_XPORT_RATE_DELAY,
+	_DELIVERY_BATCH, VAR_DELIVERY_BATCH,
 	0,
     };
     static const PCF_STRING_NV spawn_params[] = {
@@ -8,7 +8,8 @@
 /*	\fBpostsuper\fR [\fB-psSv\fR]
 /*	[\fB-c \fIconfig_dir\fR] [\fB-d \fIqueue_id\fR]
 /*		[\fB-h \fIqueue_id\fR] [\fB-H \fIqueue_id\fR]
-/*		[\fB-r \fIqueue_id\fR] [\fIdirectory ...\fR]
+/*		[\fB-m \fIqueue_dir\fR] [\fB-r \fIqueue_id\fR]
+/*		[\fIdirectory ...\fR]
 /* DESCRIPTION
 /*	The \fBpostsuper\fR(1) command does maintenance jobs on the Postfix
 /*	queue. Use of the command is restricted to the superuser.
@@ -108,6 +109,28 @@
 /*	case.
 /* .sp
 /*	This feature is available in Postfix 2.0 and later.
+/* .IP "\fB-m \fIqueue_dir\fR"
+/*	Balance the queue load with another Postfix instance on the
+/*	same host, whose top-level queue directory is \fIqueue_dir\fR.
+/*	This is intended for \fBpostmulti\fR(1) deployments where
+/*	one instance falls behind while a sibling instance is idle.
+/*
+/*	\fBpostsuper\fR(1) reports the number of messages in the
+/*	\fBmaildrop\fR, \fBincoming\fR, \fBactive\fR and
+/*	\fBdeferred\fR queues of both instances. When the other instance has more queued
+/*	mail, half the difference is taken over: messages are moved
+/*	from the other instance's \fBdeferred\fR queue (and then its
+/*	\fBincoming\fR queue) to this instance's \fBmaildrop\fR
+/*	queue, and are then handled as with "\fBpostsuper -r\fR".
+/*	Mail in the other instance's \fBactive\fR queue is never
+/*	touched.
+/* .sp
+/*	Each message is handed over with a single rename() operation,
+/*	so that it is owned by exactly one instance at any point
+/*	in time. For this reason, both queue directories must be
+/*	in the same file system, and must have the same mail_owner.
+/* .sp
+/*	This feature is available in Postfix 3.1 and later.
 /* .IP \fB-p\fR
 /*	Purge old temporary files that are left over after system or
 /*	software crashes.
@@ -201,9 +224,11 @@
 /*	\fBsyslogd\fR(8).
 /*
 /*	\fBpostsuper\fR(1) reports the number of messages deleted with \fB-d\fR,
-/*	the number of messages requeued with \fB-r\fR, and the number of
-/*	messages whose queue file name was fixed with \fB-s\fR. The report
-/*	is written to the standard error stream and to \fBsyslogd\fR(8).
+/*	the number of messages requeued with \fB-r\fR, the number of
+/*	messages taken over from another instance with \fB-m\fR,
+/*	and the number of messages whose queue file name was fixed
+/*	with \fB-s\fR. The report is written to the standard error
+/*	stream and to \fBsyslogd\fR(8).
 /* ENVIRONMENT
 /* .ad
 /* .fi
@@ -242,6 +267,7 @@
 /* SEE ALSO
 /*	sendmail(1), Sendmail-compatible user interface
 /*	postqueue(1), unprivileged queue operations
+/*	postmulti(1), Postfix multi-instance manager
 /* LICENSE
 /* .ad
 /* .fi
@@ -291,6 +317,7 @@
 #define MAIL_QUEUE_INTERNAL
 #include <mail_queue.h>
 #include <mail_open_ok.h>
+#include <mail_scan_dir.h>
 #include <file_id.h>
 
 /* Application-specific. */
@@ -309,6 +336,7 @@
 #define ACTION_RELEASE_ONE (1<<8)	/* release named queue file(s) */
 #define ACTION_RELEASE_ALL (1<<9)	/* release all "on hold" mail */
 #define ACTION_STRUCT_RED (1<<10)	/* fix long queue ID inode fields */
+#define ACTION_MOVE_SIBLING (1<<11)	/* take over mail from other instance */
 
 #define ACTION_DEFAULT	(ACTION_STRUCT | ACTION_PURGE)
 
@@ -382,6 +410,7 @@ static int message_requeued = 0;	/* requeued messages */
 static int message_held = 0;		/* messages put on hold */
 static int message_released = 0;	/* messages released from hold */
 static int message_deleted = 0;		/* deleted messages */
+static int message_moved = 0;		/* taken from other instance */
 static int inode_fixed = 0;		/* queue id matched to inode number */
 static int inode_mismatch = 0;		/* queue id inode mismatch */
 static int position_mismatch = 0;	/* file position mismatch */
@@ -659,6 +688,130 @@ static int operate_stream(VSTREAM *fp,
     return (found);
 }
 
+/* count_queued - count the messages in a queue hierarchy */
+
+static int count_queued(const char *queue_dir)
+{
+    static const char *queue_names[] = {
+	MAIL_QUEUE_MAILDROP,
+	MAIL_QUEUE_INCOMING,
+	MAIL_QUEUE_ACTIVE,
+	MAIL_QUEUE_DEFERRED,
+	0,
+    };
+    const char **qpp;
+    VSTRING *dir_path = vstring_alloc(100);
+    SCAN_DIR *info;
+    int     count = 0;
+
+    /*
+     * This is a load estimate, not an exact census. Don't stat() every file
+     * in sight; the names are sufficient to tell queue files apart.
+     */
+    for (qpp = queue_names; *qpp != 0; qpp++) {
+	vstring_sprintf(dir_path, "%s/%s", queue_dir, *qpp);
+	info = scan_dir_open(STR(dir_path));
+	scan_dir_batch(info, MAIL_SCAN_DIR_BATCH);
+	while (mail_scan_dir_next(info) != 0)
+	    count++;
+	scan_dir_close(info);
+    }
+    vstring_free(dir_path);
+    return (count);
+}
+
+/* move_sibling - take over mail from another instance's queue */
+
+static void move_sibling(const char *sibling_dir)
+{
+    static const char *queue_names[] = {
+	MAIL_QUEUE_DEFERRED,		/* most likely backlog */
+	MAIL_QUEUE_INCOMING,
+	0,
+    };
+    const char **qpp;
+    VSTRING *old_path = vstring_alloc(100);
+    VSTRING *new_path = vstring_alloc(100);
+    struct stat st;
+    struct utimbuf tbuf;
+    SCAN_DIR *info;
+    char   *queue_id;
+    dev_t   queue_dev;
+    int     own_load;
+    int     sibling_load;
+    int     limit;
+
+    /*
+     * Sanity checks. The handoff is a single rename() operation, so that a
+     * message is owned by exactly one instance at any point in time. That
+     * works only within one file system. We also insist that the other
+     * queue is owned by our mail_owner, so that the message file remains
+     * accessible after the move.
+     */
+    if (stat(".", &st) < 0)
+	msg_fatal("stat %s: %m", var_queue_dir);
+    queue_dev = st.st_dev;
+    for (qpp = queue_names; *qpp != 0; qpp++) {
+	vstring_sprintf(old_path, "%s/%s", sibling_dir, *qpp);
+	if (stat(STR(old_path), &st) < 0)
+	    msg_fatal("stat %s: %m", STR(old_path));
+	if (st.st_dev != queue_dev)
+	    msg_fatal("%s is not in the same file system as %s",
+		      STR(old_path), var_queue_dir);
+	if (st.st_uid != var_owner_uid)
+	    msg_fatal("%s is not owned by mail_owner", STR(old_path));
+    }
+
+    /*
+     * Per-instance load report. Take over half the difference, so that two
+     * instances that run this against each other converge instead of
+     * passing the same mail back and forth.
+     */
+    own_load = count_queued(".");
+    sibling_load = count_queued(sibling_dir);
+    msg_info("%s: %d queued message%s", var_queue_dir,
+	     own_load, own_load == 1 ? "" : "s");
+    msg_info("%s: %d queued message%s", sibling_dir,
+	     sibling_load, sibling_load == 1 ? "" : "s");
+    limit = (sibling_load - own_load) / 2;
+
+    /*
+     * Move ready message files into our maildrop queue, like the requeue
+     * operation does, so that pickup(8) and cleanup(8) copy them to a new
+     * queue file. There are no name collisions with our own maildrop files:
+     * within one file system, queue IDs of existing files differ in their
+     * inode number field. Like requeue_one(), this does not touch logfiles.
+     * Files that are still being written (not ready) are skipped. When the
+     * other instance's queue manager wins the race for a file, postrename()
+     * fails with ENOENT and we move on.
+     */
+    for (qpp = queue_names; limit > 0 && *qpp != 0; qpp++) {
+	vstring_sprintf(old_path, "%s/%s", sibling_dir, *qpp);
+	info = scan_dir_open(STR(old_path));
+	scan_dir_batch(info, MAIL_SCAN_DIR_BATCH);
+	while (limit > 0 && (queue_id = mail_scan_dir_next(info)) != 0) {
+	    if (!mail_queue_id_ok(queue_id))
+		continue;
+	    vstring_sprintf(old_path, "%s/%s", scan_dir_path(info), queue_id);
+	    if (lstat(STR(old_path), &st) < 0
+		|| !S_ISREG(st.st_mode) || !READY_MESSAGE(st))
+		continue;
+	    (void) mail_queue_path(new_path, MAIL_QUEUE_MAILDROP, queue_id);
+	    if (postrename(STR(old_path), STR(new_path)) == 0) {
+		tbuf.actime = tbuf.modtime = time((time_t *) 0);
+		if (utime(STR(new_path), &tbuf) < 0)
+		    msg_warn("%s: reset time stamps: %m", STR(new_path));
+		msg_info("%s: moved from %s", queue_id, sibling_dir);
+		message_moved++;
+		limit--;
+	    }
+	}
+	scan_dir_close(info);
+    }
+    vstring_free(old_path);
+    vstring_free(new_path);
+}
+
 /* fix_queue_id - make message queue ID match inode number */
 
 static int fix_queue_id(const char *actual_path, const char *actual_queue,
@@ -777,6 +930,7 @@ static void super(const char **queues, int action)
 	 * Other per-directory initialization.
 	 */
 	info = scan_dir_open(queue_name);
+	scan_dir_batch(info, MAIL_SCAN_DIR_BATCH);
 	actual_depth = 0;
 
 	for (;;) {
@@ -1072,6 +1226,7 @@ int     main(int argc, char **argv)
     ARGV   *delete_names = 0;
     ARGV   *hold_names = 0;
     ARGV   *release_names = 0;
+    char   *sibling_dir = 0;
     char  **cpp;
 
     /*
@@ -1158,13 +1313,14 @@ int     main(int argc, char **argv)
     /*
      * Parse JCL.
      */
-    while ((c = GETOPT(argc, argv, "c:d:h:H:pr:sSv")) > 0) {
+    while ((c = GETOPT(argc, argv, "c:d:h:H:m:pr:sSv")) > 0) {
 	switch (c) {
 	default:
 	    msg_fatal("usage: %s "
 		      "[-c config_dir] "
 		      "[-d queue_id (delete)] "
 		      "[-h queue_id (hold)] [-H queue_id (un-hold)] "
+		      "[-m queue_dir (take over mail)] "
 		      "[-p (purge temporary files)] [-r queue_id (requeue)] "
 		      "[-s (structure fix)] [-S (redundant structure fix)]"
 		      "[-v (verbose)] [queue...]", argv[0]);
@@ -1195,6 +1351,12 @@ int     main(int argc, char **argv)
 	    action |= (strcmp(optarg, "ALL") == 0 ?
 		       ACTION_RELEASE_ALL : ACTION_RELEASE_ONE);
 	    break;
+	case 'm':
+	    if (*optarg != '/')
+		msg_fatal("-m requires absolute pathname");
+	    sibling_dir = optarg;
+	    action |= ACTION_MOVE_SIBLING;
+	    break;
 	case 'p':
 	    action |= ACTION_PURGE;
 	    break;
@@ -1310,7 +1472,7 @@ int     main(int argc, char **argv)
      * mass name-to-inode fixing. This ensures that queue files are in the
      * right place before the file-by-name operations are done.
      */
-    if (action & ~ACTIONS_BY_QUEUE_ID)
+    if (action & ~(ACTIONS_BY_QUEUE_ID | ACTION_MOVE_SIBLING))
 	super(queues, action);
 
     /*
@@ -1413,6 +1575,13 @@ int     main(int argc, char **argv)
 	}
     }
 
+    /*
+     * Take over mail from another instance's queue. This is done last, so
+     * that our own queue is in order before we add to it.
+     */
+    if (action & ACTION_MOVE_SIBLING)
+	move_sibling(sibling_dir);
+
     /*
      * Report.
      */
@@ -1428,6 +1597,9 @@ int     main(int argc, char **argv)
     if (message_released > 0)
 	msg_info("Released from hold: %d message%s",
 		 message_released, message_released > 1 ? "s" : "");
+    if (message_moved > 0)
+	msg_info("Moved from %s: %d message%s", sibling_dir,
+		 message_moved, message_moved > 1 ? "s" : "");
     if (inode_fixed > 0)
 	msg_info("Renamed to match inode number: %d message%s", inode_fixed,
 		 inode_fixed > 1 ? "s" : "");
@@ -309,6 +309,11 @@
 /*	destination.
 /* .IP "\fItransport\fB_transport_rate_delay $default_transport_rate_delay
 /*	Idem, for delivery via the named message \fItransport\fR.
+/* .IP "\fBdefault_delivery_batch_limit (1)\fR"
+/*	The default maximal number of delivery requests that the queue
+/*	manager sends over one connection to a delivery agent.
+/* .IP "\fItransport\fB_delivery_batch_limit $default_delivery_batch_limit
+/*	Idem, for delivery via the named message \fItransport\fR.
 /* SAFETY CONTROLS
 /* .ad
 /* .fi
@@ -318,6 +323,13 @@
 /* .IP "\fBqmgr_ipc_timeout (60s)\fR"
 /*	The time limit for the queue manager to send or receive information
 /*	over an internal communication channel.
+/* .PP
+/*	Available in Postfix version 3.1 and later:
+/* .IP "\fBqmgr_checkpoint_interval (0s)\fR"
+/*	The time between updates of the file in $data_directory where
+/*	the queue manager saves its per-destination concurrency and
+/*	dead-site state, so that this state survives a queue manager
+/*	restart.
 /* MISCELLANEOUS CONTROLS
 /* .ad
 /* .fi
@@ -460,6 +472,8 @@ char   *var_conc_neg_feedback;
 int     var_conc_cohort_limit;
 int     var_conc_feedback_debug;
 int     var_xport_rate_delay;
+int     var_delivery_batch;
+int     var_qmgr_checkpoint;
 int     var_dest_rate_delay;
 char   *var_def_filter_nexthop;
 int     var_qmgr_daemon_timeout;
@@ -639,6 +653,7 @@ static void pre_accept(char *unused_name, char **unused_argv)
 static void qmgr_pre_init(char *unused_name, char **unused_argv)
 {
     flush_init();
+    qmgr_checkpoint_init();
 }
 
 /* qmgr_post_init - post-jail initialization */
@@ -692,6 +707,7 @@ static void qmgr_post_init(char *name, char **unused_argv)
     qmgr_scans[QMGR_SCAN_IDX_DEFERRED] = qmgr_scan_create(MAIL_QUEUE_DEFERRED);
     qmgr_scan_request(qmgr_scans[QMGR_SCAN_IDX_INCOMING], QMGR_SCAN_START);
     qmgr_deferred_run_event(0, (void *) 0);
+    qmgr_checkpoint_start();
 }
 
 MAIL_VERSION_STAMP_DECLARE;
@@ -720,6 +736,7 @@ int     main(int argc, char **argv)
 	VAR_DEST_RATE_DELAY, DEF_DEST_RATE_DELAY, &var_dest_rate_delay, 0, 0,
 	VAR_QMGR_DAEMON_TIMEOUT, DEF_QMGR_DAEMON_TIMEOUT, &var_qmgr_daemon_timeout, 1, 0,
 	VAR_QMGR_IPC_TIMEOUT, DEF_QMGR_IPC_TIMEOUT, &var_qmgr_ipc_timeout, 1, 0,
+	VAR_QMGR_CHECKPOINT, DEF_QMGR_CHECKPOINT, &var_qmgr_checkpoint, 0, 0,
 	0,
     };
     static const CONFIG_INT_TABLE int_table[] = {
@@ -736,6 +753,7 @@ int     main(int argc, char **argv)
 	VAR_INIT_DEST_CON, DEF_INIT_DEST_CON, &var_init_dest_concurrency, 1, 0,
 	VAR_DEST_CON_LIMIT, DEF_DEST_CON_LIMIT, &var_dest_con_limit, 0, 0,
 	VAR_DEST_RCPT_LIMIT, DEF_DEST_RCPT_LIMIT, &var_dest_rcpt_limit, 0, 0,
+	VAR_DELIVERY_BATCH, DEF_DELIVERY_BATCH, &var_delivery_batch, 1, 0,
 	VAR_LOCAL_RCPT_LIMIT, DEF_LOCAL_RCPT_LIMIT, &var_local_rcpt_lim, 0, 0,
 	VAR_LOCAL_CON_LIMIT, DEF_LOCAL_CON_LIMIT, &var_local_con_lim, 0, 0,
 	VAR_CONC_COHORT_LIM, DEF_CONC_COHORT_LIM, &var_conc_cohort_limit, 0, 0,
@@ -206,6 +206,7 @@ struct QMGR_TRANSPORT {
     int     fail_cohort_limit;		/* flow shutdown control */
     int     xport_rate_delay;		/* suspend per delivery */
     int     rate_delay;			/* suspend per delivery */
+    int     batch_limit;		/* requests per agent connection */
 };
 
 #define QMGR_TRANSPORT_STAT_DEAD	(1<<1)
@@ -214,6 +215,8 @@ struct QMGR_TRANSPORT {
 typedef void (*QMGR_TRANSPORT_ALLOC_NOTIFY) (QMGR_TRANSPORT *, VSTREAM *);
 extern QMGR_TRANSPORT *qmgr_transport_select(void);
 extern void qmgr_transport_alloc(QMGR_TRANSPORT *, QMGR_TRANSPORT_ALLOC_NOTIFY);
+extern int qmgr_transport_reserve(QMGR_TRANSPORT *);
+extern void qmgr_transport_release(QMGR_TRANSPORT *);
 extern void qmgr_transport_throttle(QMGR_TRANSPORT *, DSN *);
 extern void qmgr_transport_unthrottle(QMGR_TRANSPORT *);
 extern QMGR_TRANSPORT *qmgr_transport_create(const char *);
@@ -249,6 +252,7 @@ struct QMGR_QUEUE {
     QMGR_ENTRY_LIST busy;		/* messages on the wire */
     QMGR_QUEUE_LIST peers;		/* neighbor queues */
     DSN    *dsn;			/* why unavailable */
+    time_t  dead_until;			/* unthrottle timer deadline */
     time_t  clog_time_to_warn;		/* time of last warning */
     int     blocker_tag;		/* tagged if blocks job list */
 };
@@ -265,6 +269,23 @@ extern void qmgr_queue_unthrottle(QMGR_QUEUE *);
 extern QMGR_QUEUE *qmgr_queue_find(QMGR_TRANSPORT *, const char *);
 extern void qmgr_queue_suspend(QMGR_QUEUE *, int);
 
+ /*
+  * Scheduler state checkpoint, to speed up recovery after restart.
+  */
+typedef struct QMGR_CHECKPOINT_INFO {
+    int     window;			/* concurrency window */
+    double  success;			/* accumulated positive feedback */
+    double  failure;			/* accumulated negative feedback */
+    double  fail_cohorts;		/* pseudo-cohort failure count */
+    time_t  dead_until;			/* zero, or end of dead time */
+    DSN    *dsn;			/* why dead, or null */
+} QMGR_CHECKPOINT_INFO;
+
+extern void qmgr_checkpoint_init(void);
+extern void qmgr_checkpoint_start(void);
+extern QMGR_CHECKPOINT_INFO *qmgr_checkpoint_find(QMGR_TRANSPORT *, const char *);
+extern void qmgr_checkpoint_free(QMGR_CHECKPOINT_INFO *);
+
  /*
   * Exclusive queue states. Originally there were only two: "throttled" and
   * "not throttled". It was natural to encode these in the queue window size.
@@ -300,6 +321,7 @@ extern void qmgr_queue_suspend(QMGR_QUEUE *, int);
   */
 struct QMGR_ENTRY {
     VSTREAM *stream;			/* delivery process */
+    int     stream_uses;		/* requests sent over stream */
     QMGR_MESSAGE *message;		/* message info */
     RECIPIENT_LIST rcpt_list;		/* as many as it takes */
     QMGR_QUEUE *queue;			/* parent linkage */
@@ -439,6 +461,7 @@ struct QMGR_PEER {
 };
 
 extern QMGR_ENTRY *qmgr_job_entry_select(QMGR_TRANSPORT *);
+extern QMGR_ENTRY *qmgr_job_entry_select_queue(QMGR_QUEUE *);
 extern QMGR_PEER *qmgr_peer_select(QMGR_JOB *);
 extern void qmgr_job_blocker_update(QMGR_QUEUE *);
 
@@ -0,0 +1,405 @@
+/*++
+/* NAME
+/*	qmgr_checkpoint 3
+/* SUMMARY
+/*	scheduler state checkpoint
+/* SYNOPSIS
+/*	#include "qmgr.h"
+/*
+/*	void	qmgr_checkpoint_init()
+/*
+/*	void	qmgr_checkpoint_start()
+/*
+/*	QMGR_CHECKPOINT_INFO *qmgr_checkpoint_find(transport, name)
+/*	QMGR_TRANSPORT *transport;
+/*	const char *name;
+/*
+/*	void	qmgr_checkpoint_free(info)
+/*	QMGR_CHECKPOINT_INFO *info;
+/* DESCRIPTION
+/*	This module periodically saves the per-destination scheduler
+/*	state (concurrency window, concurrency feedback, and dead-site
+/*	status) to a file, and makes the saved state available to a
+/*	new queue manager process after restart. Without this, a
+/*	restarted queue manager would have to re-learn each destination
+/*	concurrency from the initial_destination_concurrency value,
+/*	and would re-try sites that were just declared dead.
+/*
+/*	Message and recipient state is not saved: that information
+/*	is already in the queue files, and the queue manager moves
+/*	left-over active queue files back to the incoming queue upon
+/*	restart.
+/*
+/*	qmgr_checkpoint_init() opens the checkpoint file and reads
+/*	the information saved by an earlier queue manager process.
+/*	Information that is older than the maximal backoff time, or
+/*	that is incomplete, is ignored. This function must be called
+/*	before the process enters the optional chroot jail. It does
+/*	nothing when checkpointing is disabled.
+/*
+/*	qmgr_checkpoint_start() starts a timer that updates the
+/*	checkpoint file periodically. The first update discards
+/*	information that was read by qmgr_checkpoint_init() and
+/*	that was not claimed with qmgr_checkpoint_find().
+/*
+/*	qmgr_checkpoint_find() looks up and removes the saved state
+/*	for the named transport and destination queue. The result
+/*	is null when no information is available. The caller takes
+/*	ownership of the result, including the dsn member.
+/*
+/*	qmgr_checkpoint_free() destroys the result from
+/*	qmgr_checkpoint_find().
+/* FILES
+/*	$data_directory/\fIprocess_name\fR.checkpoint
+/* CONFIGURATION PARAMETERS
+/*	qmgr_checkpoint_interval, time between checkpoint file updates
+/*	data_directory, location of the checkpoint file
+/*	maximal_backoff_time, maximal age of information that is used
+/* DIAGNOSTICS
+/*	Warnings: I/O errors, malformed checkpoint file.
+/* LICENSE
+/* .ad
+/* .fi
+/*	The Secure Mailer license must be distributed with this software.
+/* AUTHOR(S)
+/*	Wietse Venema
+/*	Google, Inc.
+/*	111 8th Avenue
+/*	New York, NY 10011, USA
+/*--*/
+
+/* System library. */
+
+#include <sys_defs.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <stdio.h>			/* sscanf() */
+#include <string.h>
+
+/* Utility library. */
+
+#include <msg.h>
+#include <mymalloc.h>
+#include <vstream.h>
+#include <vstring.h>
+#include <vstring_vstream.h>
+#include <htable.h>
+#include <events.h>
+#include <stringops.h>
+#include <split_at.h>
+#include <iostuff.h>
+
+/* Global library. */
+
+#include <mail_params.h>
+#include <mail_proto.h>
+#include <dsn.h>
+#include <dsn_util.h>
+
+/* Application-specific. */
+
+#include "qmgr.h"
+
+ /*
+  * The checkpoint file has a header line with a version and time stamp,
+  * one line per destination queue with non-default state, and a trailer
+  * with the number of destination lines. A file without valid trailer was
+  * truncated by a crash in the middle of an update, and is ignored.
+  */
+#define QMGR_CHECKPOINT_MAGIC	"qmgr_checkpoint"
+#define QMGR_CHECKPOINT_VERSION	1
+#define QMGR_CHECKPOINT_END	"end"
+#define QMGR_CHECKPOINT_SUFFIX	".checkpoint"
+
+static char *qmgr_checkpoint_path;
+static VSTREAM *qmgr_checkpoint_fp;
+static HTABLE *qmgr_checkpoint_table;
+
+#define STR(x)	vstring_str(x)
+
+/* qmgr_checkpoint_key - make lookup key */
+
+static const char *qmgr_checkpoint_key(const char *transport, const char *name)
+{
+    static VSTRING *key;
+
+    if (key == 0)
+	key = vstring_alloc(100);
+    vstring_sprintf(key, "%s\t%s", transport, name);
+    return (STR(key));
+}
+
+/* qmgr_checkpoint_free - destroy saved queue state */
+
+void    qmgr_checkpoint_free(QMGR_CHECKPOINT_INFO *info)
+{
+    if (info->dsn)
+	dsn_free(info->dsn);
+    myfree((void *) info);
+}
+
+/* qmgr_checkpoint_free_wrapper - htable_free() call-back */
+
+static void qmgr_checkpoint_free_wrapper(void *ptr)
+{
+    qmgr_checkpoint_free((QMGR_CHECKPOINT_INFO *) ptr);
+}
+
+/* qmgr_checkpoint_parse - parse one destination line */
+
+static int qmgr_checkpoint_parse(char *line, HTABLE *table)
+{
+    char   *field[8];
+    char   *cp = line;
+    char   *reason;
+    QMGR_CHECKPOINT_INFO *info;
+    const char *key;
+    int     n;
+
+    /*
+     * Format: transport, queue name, window, success, failure,
+     * fail_cohorts, dead_until, status, reason. The reason is last, so that
+     * it may contain any character except newline.
+     */
+    for (n = 0; n < 8; n++) {
+	field[n] = cp;
+	if ((cp = split_at(cp, '\t')) == 0)
+	    return (-1);
+    }
+    reason = cp;
+    if (*field[0] == 0 || *field[1] == 0)
+	return (-1);
+    key = qmgr_checkpoint_key(field[0], field[1]);
+    if (htable_locate(table, key) != 0)
+	return (-1);
+    info = (QMGR_CHECKPOINT_INFO *) mymalloc(sizeof(*info));
+    info->window = atoi(field[2]);
+    info->success = strtod(field[3], (char **) 0);
+    info->failure = strtod(field[4], (char **) 0);
+    info->fail_cohorts = strtod(field[5], (char **) 0);
+    info->dead_until = (time_t) strtol(field[6], (char **) 0, 10);
+    if (info->window <= 0 && dsn_valid(field[7]) && *reason) {
+	DSN     dsn;
+
+	info->window = 0;
+	(void) DSN_SIMPLE(&dsn, field[7], reason);
+	info->dsn = DSN_COPY(&dsn);
+    } else if (info->window > 0) {
+	info->dsn = 0;
+	info->dead_until = 0;
+    } else {
+	myfree((void *) info);
+	return (-1);
+    }
+    (void) htable_enter(table, key, (void *) info);
+    return (0);
+}
+
+/* qmgr_checkpoint_read - read saved state */
+
+static void qmgr_checkpoint_read(VSTREAM *fp)
+{
+    VSTRING *buf = vstring_alloc(100);
+    HTABLE *table = htable_create(1);
+    struct timeval start;
+    struct timeval finish;
+    long    stamp = 0;
+    int     version;
+    int     count = -1;
+    int     malformed = 0;
+    int     lineno = 1;
+    char    junk;
+
+    GETTIMEOFDAY(&start);
+
+    /*
+     * Validate the header. Discard information that is too old to be
+     * useful; the sites that were dead then may be alive now.
+     */
+    if (vstring_get_nonl(buf, fp) == VSTREAM_EOF) {
+	/* Empty file: first time, or checkpointing was just enabled. */
+    } else if (sscanf(STR(buf), QMGR_CHECKPOINT_MAGIC " %d %ld%c",
+		      &version, &stamp, &junk) != 2
+	       || version != QMGR_CHECKPOINT_VERSION) {
+	msg_warn("%s: line %d: bad header -- ignoring this file",
+		 qmgr_checkpoint_path, lineno);
+    } else if (event_time() - stamp > var_max_backoff_time
+	       || stamp > event_time()) {
+	if (msg_verbose)
+	    msg_info("%s: time stamp out of range -- ignoring this file",
+		     qmgr_checkpoint_path);
+    } else {
+	while (vstring_get_nonl(buf, fp) != VSTREAM_EOF) {
+	    lineno++;
+	    if (strncmp(STR(buf), QMGR_CHECKPOINT_END " ",
+			sizeof(QMGR_CHECKPOINT_END)) == 0) {
+		count = atoi(STR(buf) + sizeof(QMGR_CHECKPOINT_END));
+		break;
+	    }
+	    if (qmgr_checkpoint_parse(STR(buf), table) < 0) {
+		malformed = 1;
+		msg_warn("%s: line %d: malformed entry -- ignoring this file",
+			 qmgr_checkpoint_path, lineno);
+		break;
+	    }
+	}
+	if (count >= 0 && count != table->used) {
+	    msg_warn("%s: line %d: expected %d entries, found %ld"
+		     " -- ignoring this file", qmgr_checkpoint_path, lineno,
+		     count, (long) table->used);
+	    count = -1;
+	} else if (count < 0 && !malformed) {
+	    msg_warn("%s: premature end-of-file -- ignoring this file",
+		     qmgr_checkpoint_path);
+	}
+    }
+
+    /*
+     * Make the information available to qmgr_queue_create(), and report how
+     * long it took, so that the cost of recovery is visible in the logfile.
+     */
+    if (count > 0) {
+	GETTIMEOFDAY(&finish);
+	msg_info("restored state for %d destination%s from %s"
+		 " (age %lds, %.3f ms)", count, count == 1 ? "" : "s",
+		 qmgr_checkpoint_path, (long) (event_time() - stamp),
+		 (finish.tv_sec - start.tv_sec) * 1000.0
+		 + (finish.tv_usec - start.tv_usec) / 1000.0);
+	qmgr_checkpoint_table = table;
+    } else {
+	htable_free(table, qmgr_checkpoint_free_wrapper);
+    }
+    vstring_free(buf);
+}
+
+/* qmgr_checkpoint_write - save scheduler state */
+
+static void qmgr_checkpoint_write(void)
+{
+    static VSTRING *reason;
+    QMGR_TRANSPORT *transport;
+    QMGR_QUEUE *queue;
+    int     count = 0;
+
+    if (reason == 0)
+	reason = vstring_alloc(100);
+
+    /*
+     * Update the file in place; the file descriptor was opened before we
+     * entered the chroot jail and dropped privileges. The trailer line
+     * protects against a crash in the middle of an update.
+     */
+    if (vstream_fseek(qmgr_checkpoint_fp, (off_t) 0, SEEK_SET) < 0) {
+	msg_warn("seek %s: %m", qmgr_checkpoint_path);
+	return;
+    }
+    vstream_fprintf(qmgr_checkpoint_fp, "%s %d %ld\n", QMGR_CHECKPOINT_MAGIC,
+		    QMGR_CHECKPOINT_VERSION, (long) event_time());
+    for (transport = qmgr_transport_list.next; transport;
+	 transport = transport->peers.next) {
+	if (strcmp(transport->name, MAIL_SERVICE_RETRY) == 0
+	    || strcmp(transport->name, MAIL_SERVICE_ERROR) == 0)
+	    continue;
+	for (queue = transport->queue_list.next; queue;
+	     queue = queue->peers.next) {
+	    if (strpbrk(queue->name, "\t\n") != 0)
+		continue;
+	    if (QMGR_QUEUE_READY(queue)) {
+		if (queue->window == transport->init_dest_concurrency
+		    && queue->success == 0 && queue->failure == 0
+		    && queue->fail_cohorts == 0)
+		    continue;
+		vstream_fprintf(qmgr_checkpoint_fp,
+				"%s\t%s\t%d\t%g\t%g\t%g\t0\t\t\n",
+				transport->name, queue->name, queue->window,
+				queue->success, queue->failure,
+				queue->fail_cohorts);
+	    } else if (QMGR_QUEUE_THROTTLED(queue) && queue->dsn != 0) {
+		vstring_strcpy(reason, queue->dsn->reason);
+		(void) printable(STR(reason), '?');
+		vstream_fprintf(qmgr_checkpoint_fp,
+				"%s\t%s\t0\t0\t0\t0\t%ld\t%s\t%s\n",
+				transport->name, queue->name,
+				(long) queue->dead_until,
+				queue->dsn->status, STR(reason));
+	    } else {
+		continue;
+	    }
+	    count++;
+	}
+    }
+    vstream_fprintf(qmgr_checkpoint_fp, "%s %d\n", QMGR_CHECKPOINT_END, count);
+    if (vstream_fflush(qmgr_checkpoint_fp) != 0
+	|| ftruncate(vstream_fileno(qmgr_checkpoint_fp),
+		     vstream_ftell(qmgr_checkpoint_fp)) < 0)
+	msg_warn("write %s: %m", qmgr_checkpoint_path);
+    if (msg_verbose)
+	msg_info("%s: saved state for %d destinations",
+		 qmgr_checkpoint_path, count);
+}
+
+/* qmgr_checkpoint_event - periodic checkpoint */
+
+static void qmgr_checkpoint_event(int unused_event, void *unused_context)
+{
+
+    /*
+     * Information that wasn't claimed by now is for destinations that have
+     * no mail in the queue.
+     */
+    if (qmgr_checkpoint_table) {
+	htable_free(qmgr_checkpoint_table, qmgr_checkpoint_free_wrapper);
+	qmgr_checkpoint_table = 0;
+    }
+    qmgr_checkpoint_write();
+    event_request_timer(qmgr_checkpoint_event, (void *) 0, var_qmgr_checkpoint);
+}
+
+/* qmgr_checkpoint_init - read saved state */
+
+void    qmgr_checkpoint_init(void)
+{
+    int     fd;
+
+    if (var_qmgr_checkpoint <= 0)
+	return;
+
+    qmgr_checkpoint_path = concatenate(var_data_dir, "/", var_procname,
+				       QMGR_CHECKPOINT_SUFFIX, (char *) 0);
+    if ((fd = open(qmgr_checkpoint_path, O_RDWR | O_CREAT, 0600)) < 0) {
+	msg_warn("open %s: %m -- scheduler state checkpoint is disabled",
+		 qmgr_checkpoint_path);
+	return;
+    }
+    close_on_exec(fd, CLOSE_ON_EXEC);
+    qmgr_checkpoint_fp = vstream_fdopen(fd, O_RDWR);
+    qmgr_checkpoint_read(qmgr_checkpoint_fp);
+}
+
+/* qmgr_checkpoint_start - start periodic checkpoint */
+
+void    qmgr_checkpoint_start(void)
+{
+    if (qmgr_checkpoint_fp)
+	event_request_timer(qmgr_checkpoint_event, (void *) 0,
+			    var_qmgr_checkpoint);
+}
+
+/* qmgr_checkpoint_find - claim saved state for destination queue */
+
+QMGR_CHECKPOINT_INFO *qmgr_checkpoint_find(QMGR_TRANSPORT *transport,
+					           const char *name)
+{
+    QMGR_CHECKPOINT_INFO *info;
+    const char *key;
+
+    if (qmgr_checkpoint_table == 0)
+	return (0);
+    key = qmgr_checkpoint_key(transport->name, name);
+    if ((info = (QMGR_CHECKPOINT_INFO *)
+	 htable_find(qmgr_checkpoint_table, key)) != 0)
+	htable_delete(qmgr_checkpoint_table, key, (void (*) (void *)) 0);
+    return (info);
+}
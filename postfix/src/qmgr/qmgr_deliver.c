@@ -30,6 +30,17 @@
 /*	pointer if the transport accepts no connection. Upon completion
 /*	of delivery (successful or not), the stream is closed, so that the
 /*	delivery process is released.
+/*
+/*	When the transport's delivery batch limit is larger than one,
+/*	the stream is kept open after successful delivery, and the
+/*	delivery process is given another queue entry for the same
+/*	next-hop destination as soon as it announces that it is
+/*	ready, until the limit is reached. While it waits, the
+/*	delivery process occupies one of the transport's pending
+/*	delivery process slots. The delivery process is released
+/*	when it does not want more requests, when it does not become
+/*	ready within a few seconds, or when no suitable queue entry
+/*	is available.
 /* DIAGNOSTICS
 /* LICENSE
 /* .ad
@@ -104,6 +115,35 @@ int     qmgr_deliver_concurrency;
 #define DELIVER_STAT_DEFER	1	/* try some recipients later */
 #define DELIVER_STAT_CRASH	2	/* mailer internal problem */
 
+ /*
+  * A delivery process that may receive another delivery request.
+  */
+typedef struct {
+    QMGR_TRANSPORT *transport;		/* delivery transport */
+    char   *queue_name;			/* next-hop destination */
+    VSTREAM *stream;			/* delivery process */
+    int     stream_uses;		/* requests sent over stream */
+} QMGR_DELIVER_AGENT;
+
+ /*
+  * How long to wait until a kept delivery process is ready for the next
+  * request. It should be ready immediately after it reports the status of
+  * the previous request.
+  */
+#define QMGR_DELIVER_IDLE_TIME	5
+
+ /*
+  * Don't send multiple requests over one stream with rate-limited
+  * transports; those delays are enforced per delivery agent allocation.
+  */
+#define QMGR_DELIVER_CAN_BATCH(transport, uses) \
+	((transport)->batch_limit > (uses) \
+	 && (transport)->xport_rate_delay == 0 \
+	 && (transport)->rate_delay == 0)
+
+static void qmgr_deliver_start(QMGR_TRANSPORT *, VSTREAM *, int,
+			               QMGR_QUEUE *);
+
 /* qmgr_deliver_initial_reply - retrieve initial delivery process response */
 
 static int qmgr_deliver_initial_reply(VSTREAM *stream)
@@ -185,6 +225,8 @@ static int qmgr_deliver_send_request(QMGR_ENTRY *entry, VSTREAM *stream)
     flags = message->tflags
 	| entry->queue->dflags
 	| (message->inspect_xport ? DEL_REQ_FLAG_BOUNCE : DEL_REQ_FLAG_DEFLT);
+    if (QMGR_DELIVER_CAN_BATCH(entry->queue->transport, entry->stream_uses))
+	flags |= DEL_REQ_FLAG_BATCH;
     (void) QMGR_MSG_STATS(&stats, message);
     attr_print(stream, ATTR_FLAG_NONE,
 	       SEND_ATTR_INT(MAIL_ATTR_FLAGS, flags),
@@ -243,6 +285,92 @@ static void qmgr_deliver_abort(int unused_event, void *context)
 	      message->queue_id, transport->name);
 }
 
+/* qmgr_deliver_agent_free - release kept delivery process */
+
+static void qmgr_deliver_agent_free(QMGR_DELIVER_AGENT *agent)
+{
+    qmgr_transport_release(agent->transport);
+    myfree(agent->queue_name);
+    myfree((void *) agent);
+}
+
+/* qmgr_deliver_next_abort - delivery process did not announce readiness */
+
+static void qmgr_deliver_next_abort(int unused_event, void *context)
+{
+    QMGR_DELIVER_AGENT *agent = (QMGR_DELIVER_AGENT *) context;
+
+    if (msg_verbose)
+	msg_info("qmgr_deliver_next_abort: transport %s is not ready",
+		 agent->transport->name);
+    event_disable_readwrite(vstream_fileno(agent->stream));
+    (void) vstream_fclose(agent->stream);
+    qmgr_deliver_agent_free(agent);
+}
+
+/* qmgr_deliver_next - send another request to the same delivery process */
+
+static void qmgr_deliver_next(int unused_event, void *context)
+{
+    QMGR_DELIVER_AGENT *agent = (QMGR_DELIVER_AGENT *) context;
+    QMGR_TRANSPORT *transport = agent->transport;
+    VSTREAM *stream = agent->stream;
+    QMGR_QUEUE *queue;
+
+    event_cancel_timer(qmgr_deliver_next_abort, context);
+    event_disable_readwrite(vstream_fileno(stream));
+
+    /*
+     * A delivery process that does not handle multiple requests per
+     * connection simply disconnects. That is not an error. Otherwise, hand
+     * it the next queue entry for the same next-hop destination, subject to
+     * the usual concurrency constraints. The queue may have gone away while
+     * we were waiting.
+     */
+    if ((vstream_peek(stream) <= 0 && peekfd(vstream_fileno(stream)) <= 0)
+	|| qmgr_deliver_initial_reply(stream) != 0
+	|| QMGR_TRANSPORT_THROTTLED(transport)
+	|| (queue = qmgr_queue_find(transport, agent->queue_name)) == 0) {
+	(void) vstream_fclose(stream);
+    } else {
+	if (msg_verbose)
+	    msg_info("qmgr_deliver_next: transport %s site %s request %d",
+		     transport->name, queue->name, agent->stream_uses + 1);
+	qmgr_deliver_start(transport, stream, agent->stream_uses, queue);
+    }
+    qmgr_deliver_agent_free(agent);
+}
+
+/* qmgr_deliver_hold - keep delivery process for the next request */
+
+static void qmgr_deliver_hold(QMGR_ENTRY *entry)
+{
+    QMGR_DELIVER_AGENT *agent;
+
+    agent = (QMGR_DELIVER_AGENT *) mymalloc(sizeof(*agent));
+    agent->transport = entry->queue->transport;
+    agent->queue_name = mystrdup(entry->queue->name);
+    agent->stream = entry->stream;
+    agent->stream_uses = entry->stream_uses;
+    entry->stream = 0;
+    qmgr_deliver_concurrency--;
+    event_disable_readwrite(vstream_fileno(agent->stream));
+
+    /*
+     * The delivery process may have announced that it is ready in the same
+     * write as the previous status report. In that case, the announcement
+     * is already in our stream buffer, and there will be no read event.
+     */
+    if (vstream_peek(agent->stream) > 0) {
+	event_request_timer(qmgr_deliver_next, (void *) agent, 0);
+    } else {
+	event_enable_read(vstream_fileno(agent->stream), qmgr_deliver_next,
+			  (void *) agent);
+	event_request_timer(qmgr_deliver_next_abort, (void *) agent,
+			    QMGR_DELIVER_IDLE_TIME);
+    }
+}
+
 /* qmgr_deliver_update - process delivery status report */
 
 static void qmgr_deliver_update(int unused_event, void *context)
@@ -369,8 +497,19 @@ static void qmgr_deliver_update(int unused_event, void *context)
      * Release the delivery process, and give some other queue entry a chance
      * to be delivered. When all recipients for a message have been tried,
      * decide what to do next with this message: defer, bounce, delete.
+     * 
+     * After successful delivery, keep the delivery process if it may receive
+     * another request for the same destination over the same connection.
+     * The kept delivery process takes a pending delivery process slot, so
+     * that the transport's process and concurrency accounting stays the
+     * same as with a new delivery process allocation.
      */
-    QMGR_DELIVER_RELEASE_AGENT(entry);
+    if (status == 0 && QMGR_DELIVER_CAN_BATCH(transport, entry->stream_uses)
+	&& queue->todo_refcount > 0
+	&& qmgr_transport_reserve(transport))
+	qmgr_deliver_hold(entry);
+    else
+	QMGR_DELIVER_RELEASE_AGENT(entry);
     qmgr_entry_done(entry, QMGR_QUEUE_BUSY);
 }
 
@@ -378,7 +517,6 @@ static void qmgr_deliver_update(int unused_event, void *context)
 
 void    qmgr_deliver(QMGR_TRANSPORT *transport, VSTREAM *stream)
 {
-    QMGR_ENTRY *entry;
     DSN     dsn;
 
     /*
@@ -405,15 +543,27 @@ void    qmgr_deliver(QMGR_TRANSPORT *transport, VSTREAM *stream)
 	    (void) vstream_fclose(stream);
 	return;
     }
+    qmgr_deliver_start(transport, stream, 0, (QMGR_QUEUE *) 0);
+}
+
+/* qmgr_deliver_start - send request to delivery process that is ready */
+
+static void qmgr_deliver_start(QMGR_TRANSPORT *transport, VSTREAM *stream,
+			               int stream_uses, QMGR_QUEUE *queue)
+{
+    QMGR_ENTRY *entry;
+    DSN     dsn;
 
     /*
      * Find a suitable queue entry. Things may have changed since this
      * transport was allocated. If no suitable entry is found,
      * unceremoniously disconnect from the delivery process. The delivery
      * agent request reading routine is prepared for the queue manager to
-     * change its mind for no apparent reason.
+     * change its mind for no apparent reason. A delivery process that we
+     * kept after a previous request gets an entry for the same queue only.
      */
-    if ((entry = qmgr_job_entry_select(transport)) == 0) {
+    if ((entry = (queue ? qmgr_job_entry_select_queue(queue) :
+		  qmgr_job_entry_select(transport))) == 0) {
 	(void) vstream_fclose(stream);
 	return;
     }
@@ -424,6 +574,7 @@ void    qmgr_deliver(QMGR_TRANSPORT *transport, VSTREAM *stream)
      * This routine runs in response to an external event, so it does not run
      * while some other queue manipulation is happening.
      */
+    entry->stream_uses = stream_uses + 1;
     if (qmgr_deliver_send_request(entry, stream) < 0) {
 	qmgr_entry_unselect(entry);
 #if 0
@@ -19,6 +19,9 @@
 /*	QMGR_ENTRY *qmgr_job_entry_select(transport)
 /*	QMGR_TRANSPORT *transport;
 /*
+/*	QMGR_ENTRY *qmgr_job_entry_select_queue(queue)
+/*	QMGR_QUEUE *queue;
+/*
 /*	void	qmgr_job_blocker_update(queue)
 /*	QMGR_QUEUE *queue;
 /* DESCRIPTION
@@ -41,6 +44,13 @@
 /*	If necessary, an attempt to read more recipients into core is made.
 /*	This can result in creation of more job, queue and entry structures.
 /*
+/*	qmgr_job_entry_select_queue() attempts to find the next entry
+/*	suitable for delivery to the named queue, taking jobs in
+/*	job list order. It neither exercises the preempting algorithm
+/*	nor reads more recipients into core. The result is a null
+/*	pointer when the queue has no entry available, or when its
+/*	concurrency window is full.
+/*
 /*	qmgr_job_blocker_update() updates the status of blocked
 /*	jobs after a decrease in the queue's concurrency level,
 /*	after the queue is throttled, or after the queue is resumed
@@ -945,6 +955,36 @@ QMGR_ENTRY *qmgr_job_entry_select(QMGR_TRANSPORT *transport)
     return (0);
 }
 
+/* qmgr_job_entry_select_queue - select next entry for the named queue */
+
+QMGR_ENTRY *qmgr_job_entry_select_queue(QMGR_QUEUE *queue)
+{
+    QMGR_TRANSPORT *transport = queue->transport;
+    QMGR_JOB *job;
+    QMGR_PEER *peer;
+    QMGR_ENTRY *entry;
+
+    if (!QMGR_QUEUE_READY(queue) || queue->todo_refcount == 0
+	|| queue->window <= queue->busy_refcount)
+	return (0);
+
+    /*
+     * Find the first job with an entry for this queue, select that entry,
+     * and adjust the delivery slot counters as qmgr_job_entry_select() does.
+     */
+    for (job = transport->job_list.next; job; job = job->transport_peers.next) {
+	if ((peer = qmgr_peer_find(job, queue)) == 0
+	    || peer->entry_list.next == 0)
+	    continue;
+	entry = qmgr_entry_select(peer);
+	qmgr_job_count_slots(job);
+	if (!HAS_ENTRIES(job) && job->message->rcpt_offset == 0)
+	    qmgr_job_retire(job);
+	return (entry);
+    }
+    return (0);
+}
+
 /* qmgr_job_blocker_update - update "blocked job" status */
 
 void    qmgr_job_blocker_update(QMGR_QUEUE *queue)
@@ -69,6 +69,7 @@ void    qmgr_move(const char *src_queue, const char *dst_queue,
 	msg_info("start move queue %s -> %s", src_queue, dst_queue);
 
     queue_dir = scan_dir_open(src_queue);
+    scan_dir_batch(queue_dir, MAIL_SCAN_DIR_BATCH);
     while ((queue_id = mail_scan_dir_next(queue_dir)) != 0) {
 	if (mail_queue_id_ok(queue_id)) {
 	    if (time_stamp > 0) {
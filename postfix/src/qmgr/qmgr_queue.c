@@ -44,7 +44,11 @@
 /*	concurrency limit as specified with the
 /*	\fIinitial_destination_concurrency\fR configuration parameter,
 /*	provided that it does not exceed the transport-specific
-/*	concurrency limit.
+/*	concurrency limit. When the scheduler state checkpoint has
+/*	information about this destination, the queue instead
+/*	inherits the concurrency window and feedback that were in
+/*	effect before the queue manager restarted, or the dead-site
+/*	status with the remainder of its back-off time.
 /*
 /*	qmgr_queue_done() disposes of a per-destination queue after all
 /*	its entries have been taken care of. It is an error to dispose
@@ -245,6 +249,7 @@ void    qmgr_queue_unthrottle(QMGR_QUEUE *queue)
 	    msg_panic("%s: queue %s: window 0 status 0", myname, queue->name);
 	dsn_free(queue->dsn);
 	queue->dsn = 0;
+	queue->dead_until = 0;
 	/* Back from the almost grave, best concurrency is anyone's guess. */
 	if (queue->busy_refcount > 0)
 	    queue->window = queue->busy_refcount;
@@ -358,6 +363,7 @@ void    qmgr_queue_throttle(QMGR_QUEUE *queue, DSN *dsn)
      */
     if (QMGR_QUEUE_THROTTLED(queue)) {
 	queue->dsn = DSN_COPY(dsn);
+	queue->dead_until = event_time() + var_min_backoff_time;
 	event_request_timer(qmgr_queue_unthrottle_wrapper,
 			    (void *) queue, var_min_backoff_time);
 	queue->dflags = 0;
@@ -403,7 +409,9 @@ void    qmgr_queue_done(QMGR_QUEUE *queue)
 QMGR_QUEUE *qmgr_queue_create(QMGR_TRANSPORT *transport, const char *name,
 			              const char *nexthop)
 {
+    const char *myname = "qmgr_queue_create";
     QMGR_QUEUE *queue;
+    QMGR_CHECKPOINT_INFO *info;
 
     /*
      * If possible, choose an initial concurrency of > 1 so that one bad
@@ -424,10 +432,37 @@ QMGR_QUEUE *qmgr_queue_create(QMGR_TRANSPORT *transport, const char *name,
     QMGR_LIST_INIT(queue->todo);
     QMGR_LIST_INIT(queue->busy);
     queue->dsn = 0;
+    queue->dead_until = 0;
     queue->clog_time_to_warn = 0;
     queue->blocker_tag = 0;
     QMGR_LIST_APPEND(transport->queue_list, queue, peers);
     htable_enter(transport->queue_byname, name, (void *) queue);
+
+    /*
+     * After restart, pick up where the previous queue manager left off,
+     * instead of re-learning the destination concurrency from scratch or
+     * hammering a site that was just declared dead.
+     */
+    if ((info = qmgr_checkpoint_find(transport, name)) != 0) {
+	if (info->window > 0) {
+	    queue->window = info->window;
+	    if (transport->dest_concurrency_limit > 0
+		&& queue->window > transport->dest_concurrency_limit)
+		queue->window = transport->dest_concurrency_limit;
+	    queue->success = info->success;
+	    queue->failure = info->failure;
+	    queue->fail_cohorts = info->fail_cohorts;
+	} else if (info->dsn != 0 && info->dead_until > event_time()) {
+	    queue->window = QMGR_QUEUE_STAT_THROTTLED;
+	    queue->dsn = info->dsn;
+	    info->dsn = 0;
+	    queue->dead_until = info->dead_until;
+	    event_request_timer(qmgr_queue_unthrottle_wrapper, (void *) queue,
+				(int) (queue->dead_until - event_time()));
+	}
+	QMGR_LOG_WINDOW(queue);
+	qmgr_checkpoint_free(info);
+    }
     return (queue);
 }
 
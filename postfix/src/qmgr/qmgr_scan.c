@@ -105,6 +105,7 @@ static void qmgr_scan_start(QMGR_SCAN *scan_info)
     scan_info->flags = scan_info->nflags;
     scan_info->nflags = 0;
     scan_info->handle = scan_dir_open(scan_info->queue);
+    scan_dir_batch(scan_info->handle, MAIL_SCAN_DIR_BATCH);
 }
 
 /* qmgr_scan_request - request for future scan */
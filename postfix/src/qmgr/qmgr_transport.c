@@ -18,6 +18,12 @@
 /*	QMGR_TRANSPORT *transport;
 /*	void	(*notify)(QMGR_TRANSPORT *transport, VSTREAM *fp);
 /*
+/*	int	qmgr_transport_reserve(transport)
+/*	QMGR_TRANSPORT *transport;
+/*
+/*	void	qmgr_transport_release(transport)
+/*	QMGR_TRANSPORT *transport;
+/*
 /*	void	qmgr_transport_throttle(transport, dsn)
 /*	QMGR_TRANSPORT *transport;
 /*	DSN	*dsn;
@@ -47,6 +53,13 @@
 /*	qmgr_transport_alloc() while delivery process allocation for
 /*	the same transport is in progress.
 /*
+/*	qmgr_transport_reserve() claims a pending delivery process
+/*	slot for a delivery process that the application already
+/*	has, just like qmgr_transport_alloc() does for a new one.
+/*	The result is zero when the transport is throttled or
+/*	rate-locked, or when all pending slots are in use.
+/*	qmgr_transport_release() gives the slot back.
+/*
 /*	qmgr_transport_throttle blocks further allocation of delivery
 /*	processes for the named transport. Attempts to throttle a
 /*	throttled transport are ignored.
@@ -339,6 +352,28 @@ QMGR_TRANSPORT *qmgr_transport_select(void)
     return (0);
 }
 
+/* qmgr_transport_reserve - claim pending slot for existing delivery process */
+
+int     qmgr_transport_reserve(QMGR_TRANSPORT *transport)
+{
+    if ((transport->flags & QMGR_TRANSPORT_STAT_DEAD) != 0
+	|| (transport->flags & QMGR_TRANSPORT_STAT_RATE_LOCK) != 0
+	|| transport->pending >= QMGR_TRANSPORT_MAX_PEND)
+	return (0);
+    transport->pending += 1;
+    return (1);
+}
+
+/* qmgr_transport_release - give back pending slot */
+
+void    qmgr_transport_release(QMGR_TRANSPORT *transport)
+{
+    if (transport->pending <= 0)
+	msg_panic("qmgr_transport_release: no pending slot: %s",
+		  transport->name);
+    transport->pending -= 1;
+}
+
 /* qmgr_transport_alloc - allocate delivery process */
 
 void    qmgr_transport_alloc(QMGR_TRANSPORT *transport, QMGR_TRANSPORT_ALLOC_NOTIFY notify)
@@ -441,6 +476,8 @@ QMGR_TRANSPORT *qmgr_transport_create(const char *name)
     transport->rate_delay = get_mail_conf_time2(name, _DEST_RATE_DELAY,
 						var_dest_rate_delay,
 						's', 0, 0);
+    transport->batch_limit = get_mail_conf_int2(name, _DELIVERY_BATCH,
+						var_delivery_batch, 1, 0);
 
     if (transport->rate_delay > 0)
 	transport->dest_concurrency_limit = 1;
@@ -351,6 +351,8 @@ static void showq_service(VSTREAM *client, char *unused_service, char **argv)
 	SCAN_DIR *scan = scan_dir_open(qp->name);
 	char   *saved_id = 0;
 
+	scan_dir_batch(scan, MAIL_SCAN_DIR_BATCH);
+
 	while ((id = qp->scan_next(scan)) != 0) {
 
 	    /*
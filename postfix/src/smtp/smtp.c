@@ -1003,6 +1003,7 @@ static void smtp_service(VSTREAM *client_stream, char *service, char **argv)
 {
     DELIVER_REQUEST *request;
     int     status;
+    int     batch;
 
     /*
      * Sanity check. This service takes no command-line arguments.
@@ -1017,10 +1018,18 @@ static void smtp_service(VSTREAM *client_stream, char *service, char **argv)
      * read a request from the queue manager, and (3) report the completion
      * status of that request. All connection-management stuff is handled by
      * the common code in single_server.c.
+     * 
+     * The queue manager may send more requests over the same connection, so
+     * that we can deliver a batch of messages without being re-elected by
+     * the master. Subsequent deliveries to the same destination then find
+     * the session in the connection cache.
      */
-    if ((request = deliver_request_read(client_stream)) != 0) {
+    while ((request = deliver_request_read(client_stream)) != 0) {
+	batch = (request->flags & DEL_REQ_FLAG_BATCH);
 	status = deliver_message(service, request);
-	deliver_request_done(client_stream, request, status);
+	if (deliver_request_done(client_stream, request, status) != 0
+	    || batch == 0)
+	    break;
     }
 }
 
@@ -245,6 +245,15 @@ char   *xfer_request[SMTP_STATE_LAST] = {
      && (session->features & SMTP_FEATURE_8BITMIME) == 0 \
      && strcmp(request->encoding, MAIL_ATTR_ENC_7BIT) != 0)
 
+ /*
+  * I/O buffer size for the queue file and for the SMTP stream while sending
+  * message content. With the default VSTREAM buffer size, the per-line work
+  * is dwarfed by one read() and one write() system call for every 4kB of
+  * content. Buffers only grow, so the SMTP stream keeps this size for the
+  * remainder of the session, including cached connections.
+  */
+#define SMTP_DATA_BUFSIZE	(64 * 1024)
+
 #ifdef USE_TLS
 
 static int smtp_start_tls(SMTP_STATE *);
@@ -2097,8 +2106,25 @@ static int smtp_loop(SMTP_STATE *state, NOCLOBBER int send_state,
 						     (MIME_STATE_ANY_END) 0,
 						   (MIME_STATE_ERR_PRINT) 0,
 							   (void *) state);
+		else if (msg_verbose)
+		    msg_info("%s: %s: message content pass-through",
+			     myname, request->queue_id);
 		state->space_left = var_smtp_line_limit;
 
+		/*
+		 * Without MIME processing, every queue file record is copied
+		 * to the SMTP stream with only dot-stuffing and line length
+		 * control (the mime_state == 0 case below). That loop is then
+		 * bounded by system call overhead, so read and write content
+		 * in larger chunks. With MIME processing this does not hurt.
+		 */
+		vstream_control(state->src,
+				CA_VSTREAM_CTL_BUFSIZE(SMTP_DATA_BUFSIZE),
+				CA_VSTREAM_CTL_END);
+		vstream_control(session->stream,
+				CA_VSTREAM_CTL_BUFSIZE(SMTP_DATA_BUFSIZE),
+				CA_VSTREAM_CTL_END);
+
 		while ((rec_type = rec_get(state->src, session->scratch, 0)) > 0) {
 		    if (rec_type != REC_TYPE_NORM && rec_type != REC_TYPE_CONT)
 			break;
@@ -257,6 +257,10 @@
 /*	Optional list of \fIname=value\fR pairs that specify default
 /*	values for arbitrary macros that Postfix may send to Milter
 /*	applications.
+/* .IP "\fBmilter_connection_reuse (no)\fR"
+/*	Keep the connection to a Milter application open after a
+/*	session ends, and use it for the next session, instead of
+/*	connecting and negotiating again.
 /* GENERAL CONTENT INSPECTION CONTROLS
 /* .ad
 /* .fi
@@ -665,6 +669,11 @@
 /*	Attempt to look up the remote SMTP client hostname, and verify that
 /*	the name matches the client IP address.
 /* .PP
+/*	Available in Postfix version 3.1 and later:
+/* .IP "\fBsmtpd_peername_lookup_async (no)\fR"
+/*	Look up the remote SMTP client hostname while the Postfix SMTP
+/*	server sends the greeting, instead of before the greeting.
+/* .PP
 /*	The per SMTP client connection count and request rate limits are
 /*	implemented in co-operation with the \fBanvil\fR(8) service, and
 /*	are available in Postfix version 2.2 and later.
@@ -699,6 +708,12 @@
 /*	time limit per read or write system call, to a time limit to send
 /*	or receive a complete record (an SMTP command line, SMTP response
 /*	line, SMTP message content line, or TLS protocol message).
+/* .PP
+/*	Available in Postfix version 3.1 and later:
+/* .IP "\fBsmtpd_recipient_prefetch_limit (0)\fR"
+/*	The maximal number of pipelined RCPT TO addresses that the
+/*	Postfix SMTP server resolves ahead of time, with one pipelined
+/*	conversation with the \fBtrivial-rewrite\fR(8) service.
 /* TARPIT CONTROLS
 /* .ad
 /* .fi
@@ -1175,6 +1190,7 @@
 #include <smtpd_proxy.h>
 #include <smtpd_milter.h>
 #include <smtpd_expand.h>
+#include <smtpd_resolve.h>
 
  /*
   * Tunable parameters. Make sure that there is some bound on the length of
@@ -1228,6 +1244,7 @@ char   *var_local_rcpt_maps;
 bool    var_allow_untrust_route;
 int     var_smtpd_junk_cmd_limit;
 int     var_smtpd_rcpt_overlim;
+int     var_smtpd_rcpt_prefetch;
 bool    var_smtpd_sasl_enable;
 bool    var_smtpd_sasl_auth_hdr;
 char   *var_smtpd_sasl_opts;
@@ -1331,6 +1348,7 @@ char   *var_smtpd_tls_eckey_file;
 #endif
 
 bool    var_smtpd_peername_lookup;
+bool    var_smtpd_peername_async;
 int     var_plaintext_code;
 bool    var_smtpd_delay_open;
 char   *var_smtpd_milters;
@@ -1894,6 +1912,12 @@ static void helo_reset(SMTPD_STATE *state)
 static int mail_open_stream(SMTPD_STATE *state)
 {
 
+    /*
+     * The client hostname goes into the queue file and into XCLIENT or
+     * XFORWARD commands. Don't use a placeholder.
+     */
+    smtpd_peer_wait(state);
+
     /*
      * Connect to the before-queue filter when one is configured. The MAIL
      * FROM and RCPT TO commands are forwarded as received (including DSN
@@ -2571,6 +2595,7 @@ static void mail_reset(SMTPD_STATE *state)
 {
     state->msg_size = 0;
     state->act_size = 0;
+    state->rcpt_lookahead = 0;
     state->flags &= SMTPD_MASK_MAIL_KEEP;
 
     /*
@@ -2643,6 +2668,82 @@ static void mail_reset(SMTPD_STATE *state)
     }
 }
 
+/* rcpt_prefetch - resolve pipelined recipients ahead of time */
+
+static void rcpt_prefetch(SMTPD_STATE *state)
+{
+    static VSTRING *addr_buf;
+    static ARGV *addrs;
+    const char *cp;
+    const char *end;
+    const char *nl;
+    const char *start;
+    char   *text;
+    TOK822 *tree;
+    TOK822 *tp;
+    TOK822 *addr;
+    int     naddr;
+
+    /*
+     * The SMTP client may have sent a batch of RCPT TO commands. Instead of
+     * resolving one recipient per trivial-rewrite round trip, resolve the
+     * recipients that are already in the input buffer with one pipelined
+     * conversation. This is a cache warming operation; it does not affect
+     * the outcome of access checks. Skip the work when we already looked
+     * ahead at the commands in the input buffer.
+     */
+    if (state->rcpt_lookahead > 0) {
+	state->rcpt_lookahead -= 1;
+	return;
+    }
+    if (var_smtpd_rcpt_prefetch <= 0 || vstream_peek(state->client) <= 0)
+	return;
+    if (addrs == 0) {
+	addr_buf = vstring_alloc(100);
+	addrs = argv_alloc(10);
+    }
+    argv_truncate(addrs, 0);
+
+    /*
+     * A simplified version of the extract_addr() address parser. Don't log
+     * warnings; the real parser will do that when the command is executed.
+     */
+    cp = vstream_peek_data(state->client);
+    end = cp + vstream_peek(state->client);
+    for ( /* void */ ; addrs->argc < var_smtpd_rcpt_prefetch
+	 && (nl = memchr(cp, '\n', end - cp)) != 0; cp = nl + 1) {
+	if (nl - cp < 8 || strncasecmp(cp, "RCPT TO:", 8) != 0)
+	    continue;
+	state->rcpt_lookahead += 1;
+	for (start = cp + 8; start < nl && ISSPACE(*start); start++)
+	     /* void */ ;
+	if (start < nl && *start == '<') {
+	    for (cp = ++start; cp < nl && *cp != '>'; cp++)
+		 /* void */ ;
+	} else {
+	    for (cp = start; cp < nl && !ISSPACE(*cp); cp++)
+		 /* void */ ;
+	}
+	text = mystrndup(start, cp - start);
+	tree = tok822_parse(text);
+	myfree(text);
+	for (addr = 0, naddr = 0, tp = tree; tp != 0; tp = tp->next) {
+	    if (tp->type == TOK822_ADDR) {
+		addr = tp;
+		naddr += 1;
+	    }
+	}
+	if (naddr == 1) {
+	    tok822_internalize(addr_buf, addr->head, TOK822_STR_DEFL);
+	    if (*STR(addr_buf))
+		argv_add(addrs, STR(addr_buf), (char *) 0);
+	}
+	tok822_free_tree(tree);
+    }
+    if (addrs->argc > 0)
+	smtpd_resolve_prefetch(addrs);
+}
+
 /* rcpt_cmd - process RCPT TO command */
 
 static int rcpt_cmd(SMTPD_STATE *state, int argc, SMTPD_TOKEN *argv)
@@ -2700,6 +2801,8 @@ static int rcpt_cmd(SMTPD_STATE *state, int argc, SMTPD_TOKEN *argv)
 			 state->addr);
 	return (-1);
     }
+    if (SMTPD_STAND_ALONE(state) == 0)
+	rcpt_prefetch(state);
     if (argv[2].tokval == SMTPD_TOK_ERROR) {
 	state->error_mask |= MAIL_ERROR_PROTOCOL;
 	smtpd_chat_reply(state, "501 5.1.3 Bad recipient address syntax");
@@ -4762,6 +4865,8 @@ static void smtpd_proto(SMTPD_STATE *state)
 
     while ((status = vstream_setjmp(state->client)) == SMTP_ERR_NONE)
 	 /* void */ ;
+    if (status != 0)
+	smtpd_peer_wait(state);
     switch (status) {
 
     default:
@@ -4991,6 +5096,7 @@ static void smtpd_proto(SMTPD_STATE *state)
 	    }
 	    watchdog_pat();
 	    smtpd_chat_query(state);
+	    smtpd_peer_poll(state);
 	    /* Safety: protect internal interfaces against malformed UTF-8. */
 	    if (var_smtputf8_enable && valid_utf8_string(STR(state->buffer),
 						 LEN(state->buffer)) == 0) {
@@ -5241,7 +5347,8 @@ static void smtpd_service(VSTREAM *stream, char *service, char **argv)
      * machines.
      */
     smtpd_state_init(&state, stream, service);
-    msg_info("connect from %s", state.namaddr);
+    if (SMTPD_PEER_PENDING(&state) == 0)
+	msg_info("connect from %s", state.namaddr);
 
     /*
      * Disable TLS when running in stand-alone mode via "sendmail -bs".
@@ -5279,6 +5386,7 @@ static void smtpd_service(VSTREAM *stream, char *service, char **argv)
      * After the client has gone away, clean up whatever we have set up at
      * connection time.
      */
+    smtpd_peer_wait(&state);
     msg_info("disconnect from %s%s", state.namaddr,
 	     smtpd_format_cmd_stats(state.buffer));
     smtpd_state_reset(&state);
@@ -5501,6 +5609,37 @@ static void pre_jail_init(char *unused_name, char **unused_argv)
 			      var_smtpd_dns_re_filter);
 }
 
+/* smtpd_list_needs_name - does host pattern list need client hostname */
+
+static int smtpd_list_needs_name(const char *patterns)
+{
+    char   *saved_patterns = mystrdup(patterns);
+    char   *bp = saved_patterns;
+    char   *item;
+    char   *cp;
+    int     needs_name = 0;
+
+    /*
+     * Be conservative: anything other than an address or address/mask
+     * pattern, including a lookup table or file, may match the client
+     * hostname.
+     */
+    while (needs_name == 0 && (item = mystrtok(&bp, CHARS_COMMA_SP)) != 0) {
+	if (*item == '!')
+	    item++;
+	if ((cp = strchr(item, '/')) != 0)
+	    *cp = 0;
+	if (*item == '[' && (cp = strrchr(item, ']')) != 0) {
+	    *cp = 0;
+	    item++;
+	}
+	if (!valid_hostaddr(item, DONT_GRIPE))
+	    needs_name = 1;
+    }
+    myfree(saved_patterns);
+    return (needs_name);
+}
+
 /* post_jail_init - post-jail initialization */
 
 static void post_jail_init(char *unused_name, char **unused_argv)
@@ -5571,6 +5710,48 @@ static void post_jail_init(char *unused_name, char **unused_argv)
 	|| var_smtpd_cmail_limit || var_smtpd_crcpt_limit
 	|| var_smtpd_cntls_limit)
 	anvil_clnt = anvil_clnt_create();
+
+    /*
+     * Asynchronous client hostname lookup. Access checks and the queue file
+     * collect the lookup result when they need it, but the features below
+     * use the client hostname before the SMTP server greeting, or in places
+     * that don't wait for the result.
+     */
+    if (var_smtpd_peername_async) {
+	const char *conflict = 0;
+
+	if (var_smtpd_delay_reject == 0)
+	    conflict = VAR_SMTPD_DELAY_REJECT " = no";
+	else if (smtpd_milters != 0)
+	    conflict = VAR_SMTPD_MILTERS;
+	else if (*var_xclient_hosts)
+	    conflict = VAR_XCLIENT_HOSTS;
+	else if (*var_xforward_hosts)
+	    conflict = VAR_XFORWARD_HOSTS;
+	else if (*var_debug_peer_list)
+	    conflict = VAR_DEBUG_PEER_LIST;
+#ifdef USE_TLS
+	else if (var_smtpd_tls_wrappermode)
+	    conflict = VAR_SMTPD_TLS_WRAPPER;
+#endif
+	else if ((anvil_clnt != 0 || var_smtpd_cntls_limit)
+		 && smtpd_list_needs_name(var_smtpd_hoggers))
+	    conflict = VAR_SMTPD_HOGGERS;
+	else if (smtpd_list_needs_name(var_verp_clients))
+	    conflict = VAR_VERP_CLIENTS;
+#ifdef USE_SASL_AUTH
+	else if (smtpd_list_needs_name(var_smtpd_sasl_exceptions_networks))
+	    conflict = VAR_SMTPD_SASL_EXCEPTIONS_NETWORKS;
+#endif
+	else if (smtpd_list_needs_name(var_mynetworks))
+	    conflict = VAR_MYNETWORKS;
+	if (conflict != 0) {
+	    msg_warn("disabling %s: the client hostname is needed "
+		     "without waiting for the lookup result (%s)",
+		     VAR_SMTPD_PEERNAME_ASYNC, conflict);
+	    var_smtpd_peername_async = 0;
+	}
+    }
 }
 
 MAIL_VERSION_STAMP_DECLARE;
@@ -5601,6 +5782,7 @@ int     main(int argc, char **argv)
 	VAR_DEFER_CODE, DEF_DEFER_CODE, &var_defer_code, 0, 0,
 	VAR_NON_FQDN_CODE, DEF_NON_FQDN_CODE, &var_non_fqdn_code, 0, 0,
 	VAR_SMTPD_RCPT_OVERLIM, DEF_SMTPD_RCPT_OVERLIM, &var_smtpd_rcpt_overlim, 1, 0,
+	VAR_SMTPD_RCPT_PREFETCH, DEF_SMTPD_RCPT_PREFETCH, &var_smtpd_rcpt_prefetch, 0, 100,
 	VAR_SMTPD_HIST_THRSH, DEF_SMTPD_HIST_THRSH, &var_smtpd_hist_thrsh, 1, 0,
 	VAR_UNV_FROM_RCODE, DEF_UNV_FROM_RCODE, &var_unv_from_rcode, 200, 599,
 	VAR_UNV_RCPT_RCODE, DEF_UNV_RCPT_RCODE, &var_unv_rcpt_rcode, 200, 599,
@@ -5666,6 +5848,7 @@ int     main(int argc, char **argv)
 	VAR_SMTPD_TLS_SET_SESSID, DEF_SMTPD_TLS_SET_SESSID, &var_smtpd_tls_set_sessid,
 #endif
 	VAR_SMTPD_PEERNAME_LOOKUP, DEF_SMTPD_PEERNAME_LOOKUP, &var_smtpd_peername_lookup,
+	VAR_SMTPD_PEERNAME_ASYNC, DEF_SMTPD_PEERNAME_ASYNC, &var_smtpd_peername_async,
 	VAR_SMTPD_DELAY_OPEN, DEF_SMTPD_DELAY_OPEN, &var_smtpd_delay_open,
 	VAR_SMTPD_CLIENT_PORT_LOG, DEF_SMTPD_CLIENT_PORT_LOG, &var_smtpd_client_port_log,
 	0,
@@ -84,6 +84,9 @@ typedef struct {
     SOCKADDR_SIZE sockaddr_len;		/* binary client endpoint */
     int     name_status;		/* 2=ok 4=soft 5=hard 6=forged */
     int     reverse_name_status;	/* 2=ok 4=soft 5=hard */
+    int     peer_lookup_fd;		/* pending hostname lookup */
+    pid_t   peer_lookup_pid;		/* pending hostname lookup */
+    struct timeval peer_lookup_start;	/* hostname lookup start time */
     int     conn_count;			/* connections from this client */
     int     conn_rate;			/* connection rate for this client */
     int     error_count;		/* reset after DOT */
@@ -109,6 +112,7 @@ typedef struct {
     off_t   act_size;			/* END-OF-DATA message size */
     int     junk_cmds;			/* counter */
     int     rcpt_overshoot;		/* counter */
+    int     rcpt_lookahead;		/* prefetched pipelined RCPTs */
     char   *rewrite_context;		/* address rewriting context */
 
     /*
@@ -318,6 +322,10 @@ extern void smtpd_state_reset(SMTPD_STATE *);
 extern void smtpd_peer_init(SMTPD_STATE *state);
 extern void smtpd_peer_reset(SMTPD_STATE *state);
 extern int smtpd_peer_from_haproxy(SMTPD_STATE *state);
+extern void smtpd_peer_wait(SMTPD_STATE *state);
+extern void smtpd_peer_poll(SMTPD_STATE *state);
+
+#define SMTPD_PEER_PENDING(state)	((state)->peer_lookup_pid != 0)
 
 #define	SMTPD_PEER_CODE_OK	2
 #define SMTPD_PEER_CODE_TEMP	4
@@ -361,6 +361,29 @@ static int unv_from_tf_act;
   */
 static STRING_LIST *smtpd_acl_perm_log;
 
+ /*
+  * Restrictions that must wait for an asynchronous client hostname lookup.
+  */
+static const char *client_name_restrictions[] = {
+    REJECT_UNKNOWN_CLIENT_HOSTNAME,
+    REJECT_UNKNOWN_CLIENT,
+    REJECT_UNKNOWN_REVERSE_HOSTNAME,
+    CHECK_CLIENT_ACL,
+    CHECK_REVERSE_CLIENT_ACL,
+    REJECT_RHSBL_CLIENT,
+    PERMIT_RHSWL_CLIENT,
+    REJECT_RHSBL_REVERSE_CLIENT,
+    CHECK_CLIENT_NS_ACL,
+    CHECK_CLIENT_MX_ACL,
+    CHECK_CLIENT_A_ACL,
+    CHECK_REVERSE_CLIENT_NS_ACL,
+    CHECK_REVERSE_CLIENT_MX_ACL,
+    CHECK_REVERSE_CLIENT_A_ACL,
+    CHECK_POLICY_SERVICE,
+    CHECK_RELAY_DOMAINS,
+    0,
+};
+
  /*
   * YASLM.
   */
@@ -904,6 +927,7 @@ static void log_whatsup(SMTPD_STATE *state, const char *whatsup,
 {
     VSTRING *buf = vstring_alloc(100);
 
+    smtpd_peer_wait(state);
     vstring_sprintf(buf, "%s: %s: %s from %s: %s;",
 		    state->queue_id ? state->queue_id : "NOQUEUE",
 		    whatsup, state->where, state->namaddr, text);
@@ -4087,6 +4111,20 @@ static int generic_checks(SMTPD_STATE *state, ARGV *restrictions,
 	    cpp -= 1;
 	}
 
+	/*
+	 * Collect the client hostname before a restriction that needs it.
+	 */
+	if (SMTPD_PEER_PENDING(state)) {
+	    const char **np;
+
+	    for (np = client_name_restrictions; *np; np++) {
+		if (strcasecmp(name, *np) == 0) {
+		    smtpd_peer_wait(state);
+		    break;
+		}
+	    }
+	}
+
 	/*
 	 * Generic restrictions.
 	 */
@@ -5439,6 +5477,7 @@ char   *var_eod_checks = "";
 char   *var_relay_domains = "";
 char   *var_smtpd_uproxy_proto = "";
 int     var_smtpd_uproxy_tmout = 0;
+int     var_smtpd_tmout = 0;
 
 #ifdef USE_TLS
 char   *var_relay_ccerts = "";
@@ -5615,6 +5654,7 @@ int     var_smtpd_rej_unl_from;
 int     var_smtpd_rej_unl_rcpt;
 int     var_plaintext_code;
 bool    var_smtpd_peername_lookup;
+bool    var_smtpd_peername_async;
 bool    var_smtpd_client_port_log;
 char   *var_smtpd_dns_re_filter;
 
@@ -5650,6 +5690,7 @@ static const INT_TABLE int_table[] = {
     VAR_SMTPD_REJ_UNL_RCPT, DEF_SMTPD_REJ_UNL_RCPT, &var_smtpd_rej_unl_rcpt,
     VAR_PLAINTEXT_CODE, DEF_PLAINTEXT_CODE, &var_plaintext_code,
     VAR_SMTPD_PEERNAME_LOOKUP, DEF_SMTPD_PEERNAME_LOOKUP, &var_smtpd_peername_lookup,
+    VAR_SMTPD_PEERNAME_ASYNC, DEF_SMTPD_PEERNAME_ASYNC, &var_smtpd_peername_async,
     VAR_SMTPD_CLIENT_PORT_LOG, DEF_SMTPD_CLIENT_PORT_LOG, &var_smtpd_client_port_log,
     0,
 };
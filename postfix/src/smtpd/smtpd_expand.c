@@ -203,14 +203,17 @@ const char *smtpd_expand_lookup(const char *name, int unused_mode,
     if (STREQ(name, MAIL_ATTR_SERVER_NAME)) {
 	return (var_myhostname);
     } else if (STREQ(name, MAIL_ATTR_ACT_CLIENT)) {
+	smtpd_peer_wait(state);
 	return (state->namaddr);
     } else if (STREQ(name, MAIL_ATTR_ACT_CLIENT_PORT)) {
 	return (state->port);
     } else if (STREQ(name, MAIL_ATTR_ACT_CLIENT_ADDR)) {
 	return (state->addr);
     } else if (STREQ(name, MAIL_ATTR_ACT_CLIENT_NAME)) {
+	smtpd_peer_wait(state);
 	return (state->name);
     } else if (STREQ(name, MAIL_ATTR_ACT_REVERSE_CLIENT_NAME)) {
+	smtpd_peer_wait(state);
 	return (state->reverse_name);
     } else if (STREQ(name, MAIL_ATTR_ACT_HELO_NAME)) {
 	return (state->helo_name ? state->helo_name : "");
@@ -11,6 +11,15 @@
 /*
 /*	void	smtpd_peer_reset(state)
 /*	SMTPD_STATE *state;
+/*
+/*	void	smtpd_peer_wait(state)
+/*	SMTPD_STATE *state;
+/*
+/*	void	smtpd_peer_poll(state)
+/*	SMTPD_STATE *state;
+/*
+/*	int	SMTPD_PEER_PENDING(state)
+/*	SMTPD_STATE *state;
 /* DESCRIPTION
 /*	The smtpd_peer_init() routine attempts to produce a printable
 /*	version of the peer name and address of the specified socket.
@@ -87,7 +96,26 @@
 /*	unrecoverable error.
 /* .RE
 /* .PP
-/*	smtpd_peer_reset() releases memory allocated by smtpd_peer_init().
+/*	With "smtpd_peername_lookup_async = yes", smtpd_peer_init()
+/*	runs the address->name and name->address lookups in a child
+/*	process, so that the caller can send the SMTP greeting
+/*	without waiting for the DNS. Until the result is collected,
+/*	the name and reverse_name fields are set to "unknown", and
+/*	the name_status and reverse_name_status fields are set to 4.
+/*	SMTPD_PEER_PENDING() returns non-zero while a lookup result
+/*	has not been collected.
+/*
+/*	smtpd_peer_wait() collects the result from an asynchronous
+/*	client hostname lookup, waiting if necessary, updates the
+/*	name, reverse_name, namaddr and status fields, and logs the
+/*	"connect from" record. Call this before using any of those
+/*	fields. This is a null operation when no lookup is pending.
+/*
+/*	smtpd_peer_poll() is like smtpd_peer_wait(), but does
+/*	nothing when the lookup result is not yet available.
+/*
+/*	smtpd_peer_reset() releases memory allocated by smtpd_peer_init(),
+/*	and terminates a pending asynchronous hostname lookup.
 /* LICENSE
 /* .ad
 /* .fi
@@ -103,12 +131,16 @@
 
 #include <sys_defs.h>
 #include <sys/socket.h>
+#include <sys/wait.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <stdio.h>			/* strerror() */
 #include <errno.h>
 #include <netdb.h>
 #include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
 #include <htable.h>
 
 /* Utility library. */
@@ -120,6 +152,9 @@
 #include <sock_addr.h>
 #include <inet_proto.h>
 #include <split_at.h>
+#include <iostuff.h>
+#include <vstream.h>
+#include <attr.h>
 
 /* Global library. */
 
@@ -134,6 +169,14 @@
 
 static INET_PROTO_INFO *proto_info;
 
+ /*
+  * Attributes for the asynchronous hostname lookup result.
+  */
+#define SMTPD_PEER_ATTR_NAME_STATUS		"name_status"
+#define SMTPD_PEER_ATTR_REVERSE_NAME_STATUS	"reverse_name_status"
+
+#define STR(x)	vstring_str(x)
+
  /*
   * XXX If we make local endpoint (getsockname) information available to
   * Milter applications as {if_name} and {if_addr}, then we also must be able
@@ -368,6 +411,164 @@ static void smtpd_peer_sockaddr_to_hostname(SMTPD_STATE *state)
     }
 }
 
+/* smtpd_peer_start_lookup - start asynchronous client hostname lookup */
+
+static void smtpd_peer_start_lookup(SMTPD_STATE *state)
+{
+    int     pipefds[2];
+    VSTREAM *stream;
+    pid_t   pid;
+
+    /*
+     * Run the address->name and name->address lookups in a child process
+     * that reports the result over a pipe. If we can't do that, fall back
+     * to the synchronous lookup.
+     */
+    if (pipe(pipefds) < 0) {
+	msg_warn("pipe: %m -- using synchronous client hostname lookup");
+	smtpd_peer_sockaddr_to_hostname(state);
+	return;
+    }
+    switch (pid = fork()) {
+    case -1:
+	msg_warn("fork: %m -- using synchronous client hostname lookup");
+	(void) close(pipefds[0]);
+	(void) close(pipefds[1]);
+	smtpd_peer_sockaddr_to_hostname(state);
+	return;
+
+	/*
+	 * Child. Don't run exit handlers that belong to the parent process.
+	 */
+    case 0:
+	(void) close(pipefds[0]);
+	smtpd_peer_sockaddr_to_hostname(state);
+	stream = vstream_fdopen(pipefds[1], O_WRONLY);
+	attr_print(stream, ATTR_FLAG_NONE,
+		   SEND_ATTR_STR(MAIL_ATTR_ACT_CLIENT_NAME, state->name),
+		   SEND_ATTR_STR(MAIL_ATTR_ACT_REVERSE_CLIENT_NAME,
+				 state->reverse_name),
+		   SEND_ATTR_INT(SMTPD_PEER_ATTR_NAME_STATUS,
+				 state->name_status),
+		   SEND_ATTR_INT(SMTPD_PEER_ATTR_REVERSE_NAME_STATUS,
+				 state->reverse_name_status),
+		   ATTR_TYPE_END);
+	_exit(vstream_fclose(stream) != 0);
+
+	/*
+	 * Parent. Use surrogate information until the result is collected.
+	 */
+    default:
+	(void) close(pipefds[1]);
+	close_on_exec(pipefds[0], CLOSE_ON_EXEC);
+	state->peer_lookup_fd = pipefds[0];
+	state->peer_lookup_pid = pid;
+	GETTIMEOFDAY(&state->peer_lookup_start);
+	state->name = mystrdup(CLIENT_NAME_UNKNOWN);
+	state->reverse_name = mystrdup(CLIENT_NAME_UNKNOWN);
+	state->name_status = SMTPD_PEER_CODE_TEMP;
+	state->reverse_name_status = SMTPD_PEER_CODE_TEMP;
+	if (msg_verbose)
+	    msg_info("started hostname lookup for %s in process %lu",
+		     state->addr, (unsigned long) pid);
+	break;
+    }
+}
+
+/* smtpd_peer_cancel - terminate pending hostname lookup */
+
+static void smtpd_peer_cancel(SMTPD_STATE *state, int sig)
+{
+    WAIT_STATUS_T wait_status;
+
+    if (sig != 0)
+	(void) kill(state->peer_lookup_pid, sig);
+    while (waitpid(state->peer_lookup_pid, &wait_status, 0) < 0
+	   && errno == EINTR)
+	 /* void */ ;
+    if (state->peer_lookup_fd >= 0)
+	(void) close(state->peer_lookup_fd);
+    state->peer_lookup_fd = -1;
+    state->peer_lookup_pid = 0;
+}
+
+/* smtpd_peer_collect - collect asynchronous client hostname lookup result */
+
+static void smtpd_peer_collect(SMTPD_STATE *state)
+{
+    const char *myname = "smtpd_peer_collect";
+    static VSTRING *name;
+    static VSTRING *reverse_name;
+    int     name_status;
+    int     reverse_name_status;
+    struct timeval now;
+    VSTREAM *stream;
+
+    if (name == 0) {
+	name = vstring_alloc(100);
+	reverse_name = vstring_alloc(100);
+    }
+    stream = vstream_fdopen(state->peer_lookup_fd, O_RDONLY);
+    vstream_control(stream,
+		    CA_VSTREAM_CTL_TIMEOUT(var_smtpd_tmout),
+		    CA_VSTREAM_CTL_END);
+    if (attr_scan(stream, ATTR_FLAG_STRICT,
+		  RECV_ATTR_STR(MAIL_ATTR_ACT_CLIENT_NAME, name),
+		  RECV_ATTR_STR(MAIL_ATTR_ACT_REVERSE_CLIENT_NAME,
+				reverse_name),
+		  RECV_ATTR_INT(SMTPD_PEER_ATTR_NAME_STATUS, &name_status),
+		  RECV_ATTR_INT(SMTPD_PEER_ATTR_REVERSE_NAME_STATUS,
+				&reverse_name_status),
+		  ATTR_TYPE_END) != 4) {
+	msg_warn("hostname lookup for %s failed in process %lu",
+		 state->addr, (unsigned long) state->peer_lookup_pid);
+	(void) vstream_fclose(stream);
+	state->peer_lookup_fd = -1;
+	smtpd_peer_cancel(state, SIGKILL);
+    } else {
+	(void) vstream_fclose(stream);
+	state->peer_lookup_fd = -1;
+	smtpd_peer_cancel(state, 0);
+	myfree(state->name);
+	state->name = mystrdup(STR(name));
+	myfree(state->reverse_name);
+	state->reverse_name = mystrdup(STR(reverse_name));
+	state->name_status = name_status;
+	state->reverse_name_status = reverse_name_status;
+    }
+    myfree(state->namaddr);
+    state->namaddr = SMTPD_BUILD_NAMADDRPORT(state->name, state->addr,
+					     state->port);
+    if (msg_verbose) {
+	GETTIMEOFDAY(&now);
+	msg_info("%s: %s lookup time %ld ms", myname, state->namaddr,
+		 (long) (now.tv_sec - state->peer_lookup_start.tv_sec) * 1000
+		 + (now.tv_usec - state->peer_lookup_start.tv_usec) / 1000);
+    }
+
+    /*
+     * The "connect from" record was held back until the name was known.
+     */
+    msg_info("connect from %s", state->namaddr);
+}
+
+/* smtpd_peer_wait - collect asynchronous lookup result, wait if needed */
+
+void    smtpd_peer_wait(SMTPD_STATE *state)
+{
+    if (SMTPD_PEER_PENDING(state))
+	smtpd_peer_collect(state);
+}
+
+/* smtpd_peer_poll - collect asynchronous lookup result, if available */
+
+void    smtpd_peer_poll(SMTPD_STATE *state)
+{
+    if (SMTPD_PEER_PENDING(state)
+	&& read_wait(state->peer_lookup_fd, 0) == 0)
+	smtpd_peer_collect(state);
+}
+
 /* smtpd_peer_hostaddr_to_sockaddr - convert numeric string to binary */
 
 static void smtpd_peer_hostaddr_to_sockaddr(SMTPD_STATE *state)
@@ -556,6 +757,8 @@ void    smtpd_peer_init(SMTPD_STATE *state)
     state->rfc_addr = 0;
     state->port = 0;
     state->dest_addr = 0;
+    state->peer_lookup_fd = -1;
+    state->peer_lookup_pid = 0;
 
     /*
      * Determine the remote SMTP client address and port.
@@ -579,9 +782,17 @@ void    smtpd_peer_init(SMTPD_STATE *state)
      * Determine the remote SMTP client hostname. Note: some of the handlers
      * above provide surrogate endpoint information in case of error. In that
      * case, leave the surrogate information alone.
+     * 
+     * With asynchronous lookup, the caller must use smtpd_peer_wait() before
+     * it makes decisions that involve the client hostname.
      */
-    if (state->name == 0)
-	smtpd_peer_sockaddr_to_hostname(state);
+    if (state->name == 0) {
+	if (var_smtpd_peername_async && var_smtpd_peername_lookup
+	    && !SMTPD_STAND_ALONE(state))
+	    smtpd_peer_start_lookup(state);
+	else
+	    smtpd_peer_sockaddr_to_hostname(state);
+    }
 
     /*
      * Do the name[addr]:port formatting for pretty reports.
@@ -594,6 +805,8 @@ void    smtpd_peer_init(SMTPD_STATE *state)
 
 void    smtpd_peer_reset(SMTPD_STATE *state)
 {
+    if (SMTPD_PEER_PENDING(state))
+	smtpd_peer_cancel(state, SIGKILL);
     if (state->name)
 	myfree(state->name);
     if (state->reverse_name)
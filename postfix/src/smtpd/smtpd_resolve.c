@@ -11,6 +11,9 @@
 /*
 /*	const RESOLVE_REPLY *smtpd_resolve_addr(addr)
 /*	const char *addr;
+/*
+/*	void	smtpd_resolve_prefetch(addrs)
+/*	ARGV	*addrs;
 /* DESCRIPTION
 /*	This module maintains a resolve client cache that persists
 /*	across SMTP sessions (not process life times). Addresses
@@ -23,11 +26,21 @@
 /*	smtpd_resolve_addr() resolves one address or returns
 /*	a known result from cache.
 /*
+/*	smtpd_resolve_prefetch() resolves the specified addresses
+/*	that are not already cached, with one pipelined conversation
+/*	with the rewrite/resolve service, so that subsequent
+/*	smtpd_resolve_addr() calls need no round trip. Results from
+/*	an earlier call that were not used are discarded. Errors
+/*	are not fatal; smtpd_resolve_addr() then falls back to
+/*	resolving one address at a time.
+/*
 /*	Arguments:
 /* .IP cache_size
 /*	The requested cache size.
 /* .IP addr
 /*	The address to resolve.
+/* .IP addrs
+/*	The addresses to resolve ahead of time.
 /* DIAGNOSTICS
 /*	All errors are fatal.
 /* BUGS
@@ -55,6 +68,8 @@
 #include <mymalloc.h>
 #include <vstring.h>
 #include <ctable.h>
+#include <htable.h>
+#include <argv.h>
 #include <stringops.h>
 
 /* Global library. */
@@ -68,6 +83,7 @@
 #include <smtpd_resolve.h>
 
 static CTABLE *smtpd_resolve_cache;
+static HTABLE *smtpd_resolve_prefetched;
 
 #define STR(x) vstring_str(x)
 
@@ -85,6 +101,18 @@ static void *resolve_pagein(const char *addr, void *unused_context)
     if (query == 0)
 	query = vstring_alloc(10);
 
+    /*
+     * Use a prefetched result if we have one.
+     */
+    if (smtpd_resolve_prefetched != 0
+	&& (reply = (RESOLVE_REPLY *)
+	    htable_find(smtpd_resolve_prefetched, addr)) != 0) {
+	htable_delete(smtpd_resolve_prefetched, addr, (void (*) (void *)) 0);
+	if (msg_verbose)
+	    msg_info("resolve_pagein: prefetched: %s", addr);
+	return ((void *) reply);
+    }
+
     /*
      * Initialize.
      */
@@ -116,6 +144,13 @@ static void resolve_pageout(void *data, void *unused_context)
     myfree((void *) reply);
 }
 
+/* resolve_free - destroy prefetched result */
+
+static void resolve_free(void *data)
+{
+    resolve_pageout(data, (void *) 0);
+}
+
 /* smtpd_resolve_init - set up global cache */
 
 void    smtpd_resolve_init(int cache_size)
@@ -127,6 +162,10 @@ void    smtpd_resolve_init(int cache_size)
      */
     if (smtpd_resolve_cache)
 	ctable_free(smtpd_resolve_cache);
+    if (smtpd_resolve_prefetched) {
+	htable_free(smtpd_resolve_prefetched, resolve_free);
+	smtpd_resolve_prefetched = 0;
+    }
 
     /*
      * Initialize the resolved address cache. Note: the cache persists across
@@ -152,3 +191,89 @@ const RESOLVE_REPLY *smtpd_resolve_addr(const char *addr)
      */
     return (const RESOLVE_REPLY *) ctable_locate(smtpd_resolve_cache, addr);
 }
+
+/* smtpd_resolve_prefetch - resolve addresses ahead of time */
+
+void    smtpd_resolve_prefetch(ARGV *addrs)
+{
+    const char **todo;
+    VSTRING **queries;
+    const char **query_strs;
+    RESOLVE_REPLY **replies;
+    char   *tmp;
+    int     count;
+    int     n;
+
+    /*
+     * Sanity check.
+     */
+    if (smtpd_resolve_cache == 0)
+	msg_panic("smtpd_resolve_prefetch: missing initialization");
+
+    /*
+     * Discard results that were never used, and skip addresses that are
+     * already cached or that are listed more than once.
+     */
+    if (smtpd_resolve_prefetched != 0)
+	htable_free(smtpd_resolve_prefetched, resolve_free);
+    smtpd_resolve_prefetched = htable_create(addrs->argc);
+    todo = (const char **) mymalloc(sizeof(*todo) * (addrs->argc + 1));
+    for (count = n = 0; n < addrs->argc; n++) {
+	if (ctable_peek(smtpd_resolve_cache, addrs->argv[n]) == 0
+	    && htable_locate(smtpd_resolve_prefetched, addrs->argv[n]) == 0) {
+	    todo[count] = htable_enter(smtpd_resolve_prefetched,
+				       addrs->argv[n], (void *) 0)->key;
+	    count++;
+	}
+    }
+    if (count == 0) {
+	myfree((void *) todo);
+	return;
+    }
+
+    /*
+     * Rewrite and resolve all addresses with one pipelined conversation per
+     * stage. See resolve_pagein() for the one-at-a-time equivalent.
+     */
+    queries = (VSTRING **) mymalloc(sizeof(*queries) * count);
+    query_strs = (const char **) mymalloc(sizeof(*query_strs) * count);
+    replies = (RESOLVE_REPLY **) mymalloc(sizeof(*replies) * count);
+    for (n = 0; n < count; n++) {
+	queries[n] = vstring_alloc(100);
+	replies[n] = (RESOLVE_REPLY *) mymalloc(sizeof(*replies[n]));
+	resolve_clnt_init(replies[n]);
+    }
+    if (rewrite_clnt_internal_batch(MAIL_ATTR_RWR_LOCAL, count, todo,
+				    queries) == 0) {
+	for (n = 0; n < count; n++)
+	    query_strs[n] = STR(queries[n]);
+	if (resolve_clnt_batch(RESOLVE_REGULAR, RESOLVE_NULL_FROM, count,
+			       query_strs, replies) == 0) {
+	    for (n = 0; n < count; n++) {
+		tmp = mystrdup(STR(replies[n]->recipient));
+		casefold(replies[n]->recipient, tmp);	/* XXX */
+		myfree(tmp);
+		htable_locate(smtpd_resolve_prefetched, todo[n])->value =
+		    (void *) replies[n];
+		replies[n] = 0;
+	    }
+	}
+    }
+
+    /*
+     * Clean up. Placeholders without result are removed, so that
+     * resolve_pagein() falls back to the one-at-a-time interface.
+     */
+    for (n = 0; n < count; n++) {
+	if (replies[n] != 0) {
+	    htable_delete(smtpd_resolve_prefetched, todo[n],
+			  (void (*) (void *)) 0);
+	    resolve_free((void *) replies[n]);
+	}
+	vstring_free(queries[n]);
+    }
+    myfree((void *) replies);
+    myfree((void *) query_strs);
+    myfree((void *) queries);
+    myfree((void *) todo);
+}
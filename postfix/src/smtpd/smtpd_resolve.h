@@ -8,6 +8,11 @@
 /* DESCRIPTION
 /* .nf
 
+ /*
+  * Utility library.
+  */
+#include <argv.h>
+
  /*
   * Global library.
   */
@@ -18,6 +23,7 @@
   */
 extern void smtpd_resolve_init(int);
 extern const RESOLVE_REPLY *smtpd_resolve_addr(const char *);
+extern void smtpd_resolve_prefetch(ARGV *);
 
 /* LICENSE
 /* .ad
@@ -108,6 +108,7 @@ void    smtpd_state_init(SMTPD_STATE *state, VSTREAM *stream,
     state->act_size = 0;
     state->junk_cmds = 0;
     state->rcpt_overshoot = 0;
+    state->rcpt_lookahead = 0;
     state->defer_if_permit_client = 0;
     state->defer_if_permit_helo = 0;
     state->defer_if_permit_sender = 0;
@@ -41,9 +41,28 @@
 /*	As such, it presents a noticeable overhead by wasting precious
 /*	process resources. The \fBspawn\fR(8) daemon is expected to be
 /*	replaced by a more structural solution.
+/*
+/*	The \fBspawn\fR(8) daemon starts a new command for each
+/*	connection, and does not hand connections to already-running
+/*	commands; that would require it to relay the command's I/O.
+/*	When the command startup cost matters, for example with a
+/*	busy \fBcheck_policy_service\fR, run the command as a
+/*	persistent server that listens on its own socket.
 /* DIAGNOSTICS
 /*	The \fBspawn\fR(8) daemon reports abnormal child exits.
 /*	Problems are logged to \fBsyslogd\fR(8).
+/*
+/*	Before it terminates voluntarily (for example, after \fBmax_use\fR
+/*	connections or \fBmax_idle\fR seconds), the \fBspawn\fR(8) daemon
+/*	logs per-service statistics: the number of commands, the number
+/*	of abnormal exits, the number of connections that were already
+/*	waiting when a command completed, and the average and maximal
+/*	command startup (fork to exec) time and run time (Postfix 3.1
+/*	and later). A non-zero number of waiting connections suggests
+/*	that the service needs a larger process limit; the
+/*	\fBspawn\fR(8) daemon cannot see how long a connection waited
+/*	before it was accepted. With \fB-v\fR, these are also logged
+/*	per connection.
 /* SECURITY
 /* .fi
 /* .ad
@@ -127,6 +146,7 @@
 
 #include <sys_defs.h>
 #include <sys/wait.h>
+#include <sys/time.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
@@ -147,6 +167,7 @@
 #include <split_at.h>
 #include <timed_wait.h>
 #include <set_eugid.h>
+#include <iostuff.h>
 
 /* Global library. */
 
@@ -159,6 +180,10 @@
 #include <mail_conf.h>
 #include <mail_parm_split.h>
 
+/* Master process interface. */
+
+#include <master_proto.h>
+
 /* Application-specific. */
 
  /*
@@ -178,6 +203,21 @@ typedef struct {
     int     time_limit;			/* per-service time limit */
 } SPAWN_ATTR;
 
+ /*
+  * Per-service statistics, logged when the process terminates voluntarily.
+  */
+static int spawn_count;			/* commands executed */
+static int spawn_abnormal;		/* abnormal exits */
+static int spawn_queued;		/* connections kept waiting */
+static int spawn_backlog;		/* next connection was waiting */
+static double spawn_exec_total;		/* fork-to-exec time */
+static double spawn_exec_max;		/* fork-to-exec time */
+static double spawn_run_total;		/* command run time */
+static double spawn_run_max;		/* command run time */
+
+#define SPAWN_TV_DIFF(x, y) \
+	((x)->tv_sec - (y)->tv_sec + ((x)->tv_usec - (y)->tv_usec) / 1000000.0)
+
 /* get_service_attr - get service attributes */
 
 static void get_service_attr(SPAWN_ATTR *attr, char *service, char **argv)
@@ -278,6 +318,11 @@ static void spawn_service(VSTREAM *client_stream, char *service, char **argv)
     static SPAWN_ATTR attr;
     WAIT_STATUS_T status;
     ARGV   *export_env;
+    struct timeval start;
+    struct timeval done;
+    double  exec_delay = 0;
+    double  run_time;
+    int     queued;
 
     /*
      * This routine runs whenever a client connects to the UNIX-domain socket
@@ -297,6 +342,8 @@ static void spawn_service(VSTREAM *client_stream, char *service, char **argv)
     /*
      * Execute the command.
      */
+    queued = spawn_backlog;
+    GETTIMEOFDAY(&start);
     export_env = mail_parm_split(VAR_EXPORT_ENVIRON, var_export_environ);
     status = spawn_command(CA_SPAWN_CMD_STDIN(vstream_fileno(client_stream)),
 			 CA_SPAWN_CMD_STDOUT(vstream_fileno(client_stream)),
@@ -306,9 +353,33 @@ static void spawn_service(VSTREAM *client_stream, char *service, char **argv)
 			   CA_SPAWN_CMD_ARGV(attr.argv),
 			   CA_SPAWN_CMD_TIME_LIMIT(attr.time_limit),
 			   CA_SPAWN_CMD_EXPORT(export_env->argv),
+			   CA_SPAWN_CMD_EXEC_DELAY(&exec_delay),
 			   CA_SPAWN_CMD_END);
     argv_free(export_env);
 
+    /*
+     * Update statistics. A client connection that is already waiting when
+     * this command completes was kept waiting by this process.
+     */
+    GETTIMEOFDAY(&done);
+    run_time = SPAWN_TV_DIFF(&done, &start);
+    spawn_count += 1;
+    spawn_exec_total += exec_delay;
+    if (exec_delay > spawn_exec_max)
+	spawn_exec_max = exec_delay;
+    spawn_run_total += run_time;
+    if (run_time > spawn_run_max)
+	spawn_run_max = run_time;
+    if (!NORMAL_EXIT_STATUS(status))
+	spawn_abnormal += 1;
+    if (queued)
+	spawn_queued += 1;
+    spawn_backlog = (readable(MASTER_LISTEN_FD) > 0);
+    if (msg_verbose)
+	msg_info("%s: command %s %s exec delay %.3fs run time %.3fs",
+		 myname, attr.argv[0], queued ? "queued" : "not queued",
+		 exec_delay, run_time);
+
     /*
      * Warn about unsuccessful completion.
      */
@@ -322,14 +393,27 @@ static void spawn_service(VSTREAM *client_stream, char *service, char **argv)
     }
 }
 
+/* spawn_status_dump - log statistics before voluntary exit */
+
+static void spawn_status_dump(char *service, char **unused_argv)
+{
+    if (spawn_count > 0)
+	msg_info("statistics: service=%s commands=%d abnormal=%d queued=%d "
+		 "exec delay avg=%.3fs max=%.3fs run time avg=%.3fs max=%.3fs",
+		 service, spawn_count, spawn_abnormal, spawn_queued,
+		 spawn_exec_total / spawn_count, spawn_exec_max,
+		 spawn_run_total / spawn_count, spawn_run_max);
+}
+
 /* pre_accept - see if tables have changed */
 
-static void pre_accept(char *unused_name, char **unused_argv)
+static void pre_accept(char *service, char **argv)
 {
     const char *table;
 
     if ((table = dict_changed_name()) != 0) {
 	msg_info("table %s has changed -- restarting", table);
+	spawn_status_dump(service, argv);
 	exit(0);
     }
 }
@@ -361,6 +445,7 @@ int     main(int argc, char **argv)
 		       CA_MAIL_SERVER_TIME_TABLE(time_table),
 		       CA_MAIL_SERVER_POST_INIT(drop_privileges),
 		       CA_MAIL_SERVER_PRE_ACCEPT(pre_accept),
+		       CA_MAIL_SERVER_EXIT(spawn_status_dump),
 		       CA_MAIL_SERVER_PRIVILEGED,
 		       0);
 }
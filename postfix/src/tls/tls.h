@@ -231,8 +231,23 @@ typedef struct {
     X509   *errorcert;			/* Error certificate closest to leaf */
     x509_stack_t *untrusted;		/* Certificate chain fodder */
     x509_stack_t *trusted;		/* Internal root CA list */
+    int     ktls;			/* Kernel TLS offload (TLS_KTLS_*) */
 } TLS_SESS_STATE;
 
+ /*
+  * Kernel TLS offload status after the handshake. With OpenSSL 3.0 and
+  * later, "tls_ssl_options = ENABLE_KTLS" asks OpenSSL to hand record
+  * encryption to the kernel, where supported for the negotiated protocol
+  * and cipher.
+  */
+#define TLS_KTLS_SEND	(1<<0)		/* kernel encrypts */
+#define TLS_KTLS_RECV	(1<<1)		/* kernel decrypts */
+
+#define TLS_KTLS_LOG(c) \
+	((c)->ktls == (TLS_KTLS_SEND | TLS_KTLS_RECV) ? ", kTLS" : \
+	 (c)->ktls == TLS_KTLS_SEND ? ", kTLS send" : \
+	 (c)->ktls == TLS_KTLS_RECV ? ", kTLS receive" : "")
+
  /*
   * Peer status bits. TLS_CERT_FLAG_MATCHED implies TLS_CERT_FLAG_TRUSTED
   * only in the case of a hostname match.
@@ -619,6 +634,7 @@ extern TLS_SESS_STATE *tls_alloc_sess_context(int, const char *);
 extern void tls_free_context(TLS_SESS_STATE *);
 extern void tls_check_version(void);
 extern long tls_bug_bits(void);
+extern void tls_ktls_check(TLS_SESS_STATE *);
 extern void tls_print_errors(void);
 extern void tls_info_callback(const SSL *, int, int);
 extern long tls_bio_dump_cb(BIO *, int, const char *, int, long, long);
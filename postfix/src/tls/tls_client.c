@@ -1108,18 +1108,20 @@ TLS_SESS_STATE *tls_client_start(const TLS_CLIENT_START_PROPS *props)
      * functions and make the TLScontext available to those functions.
      */
     tls_stream_start(props->stream, TLScontext);
+    tls_ktls_check(TLScontext);
 
     /*
      * All the key facts in a single log entry.
      */
     if (log_mask & TLS_LOG_SUMMARY)
 	msg_info("%s TLS connection established to %s: %s with cipher %s "
-		 "(%d/%d bits)",
+		 "(%d/%d bits%s)",
 		 !TLS_CERT_IS_PRESENT(TLScontext) ? "Anonymous" :
 		 TLS_CERT_IS_MATCHED(TLScontext) ? "Verified" :
 		 TLS_CERT_IS_TRUSTED(TLScontext) ? "Trusted" : "Untrusted",
 	      props->namaddr, TLScontext->protocol, TLScontext->cipher_name,
-		 TLScontext->cipher_usebits, TLScontext->cipher_algbits);
+		 TLScontext->cipher_usebits, TLScontext->cipher_algbits,
+		 TLS_KTLS_LOG(TLScontext));
 
     tls_int_seed();
 
@@ -43,6 +43,9 @@
 /*
 /*	long	tls_bug_bits()
 /*
+/*	void	tls_ktls_check(TLScontext)
+/*	TLS_SESS_STATE *TLScontext;
+/*
 /*	void	tls_param_init()
 /*
 /*	int	tls_protocol_mask(plist)
@@ -109,6 +112,11 @@
 /*	for the run-time library. Some of the bug work-arounds are
 /*	not appropriate for some library versions.
 /*
+/*	tls_ktls_check() determines after the handshake whether
+/*	OpenSSL handed record encryption and/or decryption to the
+/*	kernel, and updates TLScontext->ktls accordingly. The result
+/*	is included in the TLS connection summary log entry.
+/*
 /*	tls_param_init() loads main.cf parameters used internally in
 /*	TLS library. Any errors are fatal.
 /*
@@ -355,6 +363,11 @@ static const LONG_NAME_MASK ssl_op_tweaks[] = {
 #define SSL_OP_NO_COMPRESSION		0
 #endif
     NAME_SSL_OP(NO_COMPRESSION),
+
+#ifndef SSL_OP_ENABLE_KTLS
+#define SSL_OP_ENABLE_KTLS		0
+#endif
+    NAME_SSL_OP(ENABLE_KTLS),
     0, 0,
 };
 
@@ -599,6 +612,19 @@ int     tls_protocol_mask(const char *plist)
 	(include ? (exclude | (TLS_KNOWN_PROTOCOLS & ~include)) : exclude));
 }
 
+/* tls_ktls_check - determine kernel TLS offload status */
+
+void    tls_ktls_check(TLS_SESS_STATE *TLScontext)
+{
+    TLScontext->ktls = 0;
+#if defined(BIO_get_ktls_send) && defined(BIO_get_ktls_recv)
+    if (BIO_get_ktls_send(SSL_get_wbio(TLScontext->con)) > 0)
+	TLScontext->ktls |= TLS_KTLS_SEND;
+    if (BIO_get_ktls_recv(SSL_get_rbio(TLScontext->con)) > 0)
+	TLScontext->ktls |= TLS_KTLS_RECV;
+#endif
+}
+
 /* tls_param_init - Load TLS related config parameters */
 
 void    tls_param_init(void)
@@ -820,6 +846,7 @@ TLS_SESS_STATE *tls_alloc_sess_context(int log_mask, const char *namaddr)
     TLScontext->errorcert = 0;
     TLScontext->untrusted = 0;
     TLScontext->trusted = 0;
+    TLScontext->ktls = 0;
 
     return (TLScontext);
 }
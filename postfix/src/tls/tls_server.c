@@ -336,6 +336,60 @@ static int ticket_cb(SSL *con, unsigned char name[], unsigned char iv[],
 
 #endif
 
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+
+/* ca_name_cmp - compare CA names for duplicate detection */
+
+static int ca_name_cmp(const X509_NAME *const * a, const X509_NAME *const * b)
+{
+    return (X509_NAME_cmp(*a, *b));
+}
+
+#endif
+
+/* server_client_ca_list - CA names to send with a certificate request */
+
+static STACK_OF(X509_NAME) *server_client_ca_list(SSL_CTX *ctx,
+						          const char *CAfile)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    STACK_OF(X509_OBJECT) *objs;
+    STACK_OF(X509_NAME) *names;
+    X509_OBJECT *obj;
+    X509_NAME *name;
+    X509   *cert;
+    int     i;
+
+    /*
+     * The CAfile was parsed already when it was loaded into the certificate
+     * store. Parsing it again with SSL_load_client_CA_file() would double
+     * the CPU cost of server initialization with a large CAfile. The store
+     * is still lazy with respect to CApath, so at this point it holds only
+     * CAfile certificates, unless the default CA locations were appended.
+     */
+    if (var_tls_append_def_CA == 0) {
+	objs = X509_STORE_get0_objects(SSL_CTX_get_cert_store(ctx));
+	if ((names = sk_X509_NAME_new(ca_name_cmp)) == 0)
+	    return (0);
+	for (i = 0; i < sk_X509_OBJECT_num(objs); i++) {
+	    obj = sk_X509_OBJECT_value(objs, i);
+	    if ((cert = X509_OBJECT_get0_X509(obj)) == 0
+		|| sk_X509_NAME_find(names, X509_get_subject_name(cert)) >= 0)
+		continue;
+	    if ((name = X509_NAME_dup(X509_get_subject_name(cert))) == 0
+		|| !sk_X509_NAME_push(names, name)) {
+		X509_NAME_free(name);
+		sk_X509_NAME_pop_free(names, X509_NAME_free);
+		return (0);
+	    }
+	}
+	(void) sk_X509_NAME_set_cmp_func(names, 0);
+	return (names);
+    }
+#endif
+    return (SSL_load_client_CA_file(CAfile));
+}
+
 /* tls_server_init - initialize the server-side TLS engine */
 
 TLS_APPL_STATE *tls_server_init(const TLS_SERVER_INIT_PROPS *props)
@@ -620,9 +674,15 @@ TLS_APPL_STATE *tls_server_init(const TLS_SERVER_INIT_PROPS *props)
 	verify_flags = SSL_VERIFY_PEER | SSL_VERIFY_CLIENT_ONCE;
     SSL_CTX_set_verify(server_ctx, verify_flags,
 		       tls_verify_certificate_callback);
-    if (*props->CAfile)
+
+    /*
+     * The client CA list is sent only with a certificate request. Don't
+     * spend CPU cycles on it when we never ask for a client certificate.
+     */
+    if (props->ask_ccert && *props->CAfile)
 	SSL_CTX_set_client_CA_list(server_ctx,
-				   SSL_load_client_CA_file(props->CAfile));
+				   server_client_ca_list(server_ctx,
+							 props->CAfile));
 
     /*
      * Initialize our own TLS server handle, before diving into the details
@@ -901,16 +961,18 @@ TLS_SESS_STATE *tls_server_post_accept(TLS_SESS_STATE *TLScontext)
      */
     if (TLScontext->stream != 0)
 	tls_stream_start(TLScontext->stream, TLScontext);
+    tls_ktls_check(TLScontext);
 
     /*
      * All the key facts in a single log entry.
      */
     if (TLScontext->log_mask & TLS_LOG_SUMMARY)
 	msg_info("%s TLS connection established from %s: %s with cipher %s "
-	      "(%d/%d bits)", !TLS_CERT_IS_PRESENT(TLScontext) ? "Anonymous"
+	      "(%d/%d bits%s)", !TLS_CERT_IS_PRESENT(TLScontext) ? "Anonymous"
 		 : TLS_CERT_IS_TRUSTED(TLScontext) ? "Trusted" : "Untrusted",
 	 TLScontext->namaddr, TLScontext->protocol, TLScontext->cipher_name,
-		 TLScontext->cipher_usebits, TLScontext->cipher_algbits);
+		 TLScontext->cipher_usebits, TLScontext->cipher_algbits,
+		 TLS_KTLS_LOG(TLScontext));
 
     tls_int_seed();
 
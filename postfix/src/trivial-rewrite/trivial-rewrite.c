@@ -477,20 +477,31 @@ static void rewrite_service(VSTREAM *stream, char *unused_service, char **argv)
      * This routine runs whenever a client connects to the UNIX-domain socket
      * dedicated to address rewriting. All connection-management stuff is
      * handled by the common code in multi_server.c.
+     * 
+     * Clients may pipeline requests. Serve all requests that are already in
+     * the input buffer, because the event loop won't tell us about them.
+     * Use separate read and write buffers, so that sending a reply does not
+     * discard the requests that are already in the input buffer.
      */
-    if (attr_scan(stream, ATTR_FLAG_STRICT | ATTR_FLAG_MORE,
-		  RECV_ATTR_STR(MAIL_ATTR_REQ, command),
-		  ATTR_TYPE_END) == 1) {
-	if (strcmp(vstring_str(command), REWRITE_ADDR) == 0) {
-	    status = rewrite_proto(stream);
-	} else if (strcmp(vstring_str(command), RESOLVE_REGULAR) == 0) {
-	    status = resolve_proto(&resolve_regular, stream);
-	} else if (strcmp(vstring_str(command), RESOLVE_VERIFY) == 0) {
-	    status = resolve_proto(&resolve_verify, stream);
-	} else {
-	    msg_warn("bad command %.30s", printable(vstring_str(command), '?'));
+    if ((vstream_flags(stream) & VSTREAM_FLAG_DOUBLE) == 0)
+	vstream_control(stream, CA_VSTREAM_CTL_DOUBLE, CA_VSTREAM_CTL_END);
+    do {
+	status = -1;
+	if (attr_scan(stream, ATTR_FLAG_STRICT | ATTR_FLAG_MORE,
+		      RECV_ATTR_STR(MAIL_ATTR_REQ, command),
+		      ATTR_TYPE_END) == 1) {
+	    if (strcmp(vstring_str(command), REWRITE_ADDR) == 0) {
+		status = rewrite_proto(stream);
+	    } else if (strcmp(vstring_str(command), RESOLVE_REGULAR) == 0) {
+		status = resolve_proto(&resolve_regular, stream);
+	    } else if (strcmp(vstring_str(command), RESOLVE_VERIFY) == 0) {
+		status = resolve_proto(&resolve_verify, stream);
+	    } else {
+		msg_warn("bad command %.30s",
+			 printable(vstring_str(command), '?'));
+	    }
 	}
-    }
+    } while (status == 0 && vstream_peek(stream) > 0);
     if (status < 0)
 	multi_server_disconnect(stream);
 }
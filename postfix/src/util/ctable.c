@@ -20,6 +20,10 @@
 /*	CTABLE	*cache;
 /*	const char *key;
 /*
+/*	const void *ctable_peek(cache, key)
+/*	CTABLE	*cache;
+/*	const char *key;
+/*
 /*	const void *ctable_newcontext(cache, context)
 /*	CTABLE	*cache;
 /*	void	*context;
@@ -49,6 +53,10 @@
 /*	ctable_refresh() flushes the value (if any) associated with
 /*	the specified key, and returns the same result as ctable_locate().
 /*
+/*	ctable_peek() returns the value that corresponds to the specified
+/*	key, or a null pointer when the key is not in the cache. This
+/*	function neither generates a value nor updates the MRU order.
+/*
 /*	ctable_newcontext() updates the context that is passed on
 /*	to call-back routines.
 /*
@@ -177,6 +185,16 @@ const void *ctable_locate(CTABLE *cache, const char *key)
     return (entry->value);
 }
 
+/* ctable_peek - look up cache entry without side effects */
+
+const void *ctable_peek(CTABLE *cache, const char *key)
+{
+    CTABLE_ENTRY *entry;
+
+    return ((entry = (CTABLE_ENTRY *) htable_find(cache->table, key)) != 0 ?
+	    entry->value : 0);
+}
+
 /* ctable_refresh - page-in fresh data for given key */
 
 const void *ctable_refresh(CTABLE *cache, const char *key)
@@ -25,6 +25,7 @@ extern void ctable_free(CTABLE *);
 extern void ctable_walk(CTABLE *, void (*) (const char *, const void *));
 extern const void *ctable_locate(CTABLE *, const char *);
 extern const void *ctable_refresh(CTABLE *, const char *);
+extern const void *ctable_peek(CTABLE *, const char *);
 extern void ctable_newcontext(CTABLE *, void *);
 
 /* LICENSE
@@ -142,6 +142,21 @@ static const char *dict_cdbq_lookup(DICT *dict, const char *name)
 
     if (status) {
 	vlen = cdb_datalen(&dict_cdbq->cdb);
+
+	/*
+	 * TinyCDB maps the whole file into memory. A value that was stored
+	 * with its null terminator can be returned from the mapping as is,
+	 * saving a copy per lookup; the mapped pages are shared with all
+	 * other processes that use this table.
+	 */
+#ifdef TINYCDB_VERSION
+	if (vlen > 0
+	    && (result = cdb_get(&dict_cdbq->cdb, vlen,
+				 cdb_datapos(&dict_cdbq->cdb))) != 0
+	    && result[vlen - 1] == '\0')
+	    return (result);
+	result = 0;
+#endif
 	if (len < vlen) {
 	    if (buf == 0)
 		buf = mymalloc(vlen + 1);
@@ -304,6 +304,7 @@
 #include <dict_dbm.h>
 #include <dict_db.h>
 #include <dict_lmdb.h>
+#include <dict_result_cache.h>
 #include <dict_nis.h>
 #include <dict_nisplus.h>
 #include <dict_ni.h>
@@ -395,6 +396,8 @@ static DICT_MAPNAMES_EXTEND_FN dict_mapnames_extend_hook;
   */
 DEFINE_DICT_LMDB_MAP_SIZE;
 DEFINE_DICT_DB_CACHE_SIZE;
+DEFINE_DICT_RESULT_CACHE_TIME;
+DEFINE_DICT_RESULT_CACHE_SIZE;
 
 /* dict_open_init - one-off initialization */
 
@@ -0,0 +1,166 @@
+/*++
+/* NAME
+/*	dict_result_cache 3
+/* SUMMARY
+/*	lookup result cache for client-server tables
+/* SYNOPSIS
+/*	#include <dict_result_cache.h>
+/*
+/*	int	dict_result_cache_time;
+/*	int	dict_result_cache_size;
+/*
+/*	DICT_RESULT_CACHE *dict_result_cache_create(dict, lookup)
+/*	DICT	*dict;
+/*	const char *(*lookup)(DICT *dict, const char *key);
+/*
+/*	const char *dict_result_cache_lookup(cache, key)
+/*	DICT_RESULT_CACHE *cache;
+/*	const char *key;
+/*
+/*	void	dict_result_cache_free(cache)
+/*	DICT_RESULT_CACHE *cache;
+/* DESCRIPTION
+/*	This module saves the round trip to a lookup server for
+/*	keys that were looked up recently. It is meant for tables
+/*	such as tcp(3) and socketmap(3), whose lookup results may
+/*	change at any time, but for which a small delay before a
+/*	change takes effect is acceptable.
+/*
+/*	dict_result_cache_create() creates a cache for the specified
+/*	table, using the current dict_result_cache_time and
+/*	dict_result_cache_size settings. The lookup argument specifies
+/*	the function that queries the server. The result is a null
+/*	pointer when caching is turned off (dict_result_cache_time
+/*	or dict_result_cache_size is not positive).
+/*
+/*	dict_result_cache_lookup() returns the result of a lookup
+/*	that was made no more than dict_result_cache_time seconds
+/*	ago. Otherwise, it calls the lookup function and saves the
+/*	result. Both "found" and "not found" results are saved.
+/*	Lookups that fail with an error are not saved. The table's
+/*	error status is updated as if the lookup function had been
+/*	called.
+/*
+/*	dict_result_cache_free() destroys the specified cache.
+/*
+/*	When the cache holds dict_result_cache_size entries, the
+/*	least-recently used entry is discarded to make room.
+/* DIAGNOSTICS
+/*	Fatal errors: out of memory.
+/* SEE ALSO
+/*	ctable(3) cache manager
+/* LICENSE
+/* .ad
+/* .fi
+/*	The Secure Mailer license must be distributed with this software.
+/*--*/
+
+/* System library. */
+
+#include <sys_defs.h>
+#include <time.h>
+
+/* Utility library. */
+
+#include <msg.h>
+#include <mymalloc.h>
+#include <ctable.h>
+#include <dict_result_cache.h>
+
+ /*
+  * Cache handle, and cache entry.
+  */
+struct DICT_RESULT_CACHE {
+    CTABLE *table;			/* cached results */
+    DICT   *dict;			/* the table */
+    DICT_RESULT_CACHE_FN lookup;	/* the real lookup */
+    int     created;			/* entry made by this request */
+};
+
+typedef struct {
+    time_t  expires;			/* expiration time */
+    int     error;			/* lookup error status */
+    char   *value;			/* result or null */
+} DICT_RESULT_CACHE_ENTRY;
+
+/* dict_result_cache_query - query server, and save result */
+
+static void *dict_result_cache_query(const char *key, void *context)
+{
+    DICT_RESULT_CACHE *cache = (DICT_RESULT_CACHE *) context;
+    DICT_RESULT_CACHE_ENTRY *entry;
+    const char *value;
+
+    value = cache->lookup(cache->dict, key);
+    entry = (DICT_RESULT_CACHE_ENTRY *) mymalloc(sizeof(*entry));
+    entry->expires = time((time_t *) 0) + dict_result_cache_time;
+    entry->error = cache->dict->error;
+    entry->value = value ? mystrdup(value) : 0;
+    cache->created = 1;
+    return ((void *) entry);
+}
+
+/* dict_result_cache_drop - destroy cache entry */
+
+static void dict_result_cache_drop(void *ptr, void *unused_context)
+{
+    DICT_RESULT_CACHE_ENTRY *entry = (DICT_RESULT_CACHE_ENTRY *) ptr;
+
+    if (entry->value)
+	myfree(entry->value);
+    myfree((void *) entry);
+}
+
+/* dict_result_cache_create - create lookup result cache */
+
+DICT_RESULT_CACHE *dict_result_cache_create(DICT *dict,
+					            DICT_RESULT_CACHE_FN lookup)
+{
+    DICT_RESULT_CACHE *cache;
+
+    if (dict_result_cache_time <= 0 || dict_result_cache_size <= 0)
+	return (0);
+    cache = (DICT_RESULT_CACHE *) mymalloc(sizeof(*cache));
+    cache->dict = dict;
+    cache->lookup = lookup;
+    cache->created = 0;
+    cache->table = ctable_create(dict_result_cache_size,
+				 dict_result_cache_query,
+				 dict_result_cache_drop, (void *) cache);
+    return (cache);
+}
+
+/* dict_result_cache_lookup - cached lookup */
+
+const char *dict_result_cache_lookup(DICT_RESULT_CACHE *cache, const char *key)
+{
+    const char *myname = "dict_result_cache_lookup";
+    const DICT_RESULT_CACHE_ENTRY *entry;
+
+    /*
+     * Query the server when the key is not in the cache, when the saved
+     * result is too old, or when the saved lookup failed.
+     */
+    cache->created = 0;
+    entry = (const DICT_RESULT_CACHE_ENTRY *) ctable_locate(cache->table, key);
+    if (cache->created == 0) {
+	if (entry->error != 0 || entry->expires <= time((time_t *) 0)) {
+	    entry = (const DICT_RESULT_CACHE_ENTRY *)
+		ctable_refresh(cache->table, key);
+	} else if (msg_verbose) {
+	    msg_info("%s: %s:%s: cached %s for key %s", myname,
+		     cache->dict->type, cache->dict->name,
+		     entry->value ? "result" : "not-found", key);
+	}
+    }
+    cache->dict->error = entry->error;
+    return (entry->value);
+}
+
+/* dict_result_cache_free - destroy lookup result cache */
+
+void    dict_result_cache_free(DICT_RESULT_CACHE *cache)
+{
+    ctable_free(cache->table);
+    myfree((void *) cache);
+}
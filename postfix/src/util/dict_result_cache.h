@@ -0,0 +1,44 @@
+#ifndef _DICT_RESULT_CACHE_H_INCLUDED_
+#define _DICT_RESULT_CACHE_H_INCLUDED_
+
+/*++
+/* NAME
+/*	dict_result_cache 3h
+/* SUMMARY
+/*	lookup result cache for client-server tables
+/* SYNOPSIS
+/*	#include <dict_result_cache.h>
+/* DESCRIPTION
+/* .nf
+
+ /*
+  * Utility library.
+  */
+#include <dict.h>
+
+ /*
+  * External interface.
+  */
+typedef struct DICT_RESULT_CACHE DICT_RESULT_CACHE;
+typedef const char *(*DICT_RESULT_CACHE_FN) (DICT *, const char *);
+
+extern DICT_RESULT_CACHE *dict_result_cache_create(DICT *, DICT_RESULT_CACHE_FN);
+extern const char *dict_result_cache_lookup(DICT_RESULT_CACHE *, const char *);
+extern void dict_result_cache_free(DICT_RESULT_CACHE *);
+
+ /*
+  * XXX Should be part of the DICT interface.
+  */
+extern int dict_result_cache_time;
+extern int dict_result_cache_size;
+
+#define DEFINE_DICT_RESULT_CACHE_TIME int dict_result_cache_time = 0
+#define DEFINE_DICT_RESULT_CACHE_SIZE int dict_result_cache_size = 1000
+
+/* LICENSE
+/* .ad
+/* .fi
+/*	The Secure Mailer license must be distributed with this software.
+/*--*/
+
+#endif
@@ -21,6 +21,11 @@
 /*	or unix:pathname:socketmap-name, where socketmap-name
 /*	specifies the socketmap name that the socketmap server uses.
 /*
+/*	Socketmaps with the same server share one connection, which
+/*	is kept open between lookups. Before a connection is reused,
+/*	the client checks that the server has not closed it. Lookup
+/*	results may be cached as described in dict_result_cache(3).
+/*
 /*	To test this module, build the netstring and dict_open test
 /*	programs. Run "./netstring nc -l portnumber" as the server,
 /*	and "./dict_open socketmap:127.0.0.1:portnumber:socketmapname"
@@ -59,6 +64,7 @@
 /*	because neither the connection nor the server are authenticated.
 /* SEE ALSO
 /*	dict(3) generic dictionary manager
+/*	dict_result_cache(3) lookup result cache
 /*	netstring(3) netstring stream I/O support
 /* DIAGNOSTICS
 /*	Fatal errors: out of memory, unknown host or service name,
@@ -95,6 +101,8 @@
 #include <split_at.h>
 #include <stringops.h>
 #include <htable.h>
+#include <iostuff.h>
+#include <dict_result_cache.h>
 #include <dict_sockmap.h>
 
  /*
@@ -105,6 +113,7 @@ typedef struct {
     char   *sockmap_name;		/* on-the-wire socketmap name */
     VSTRING *rdwr_buf;			/* read/write buffer */
     HTABLE_INFO *client_info;		/* shared endpoint name and handle */
+    DICT_RESULT_CACHE *cache;		/* optional result cache */
 } DICT_SOCKMAP;
 
  /*
@@ -156,11 +165,11 @@ typedef struct {
 #define STR(x)	vstring_str(x)
 #define LEN(x)	VSTRING_LEN(x)
 
-/* dict_sockmap_lookup - socket map lookup */
+/* dict_sockmap_query - socket map lookup */
 
-static const char *dict_sockmap_lookup(DICT *dict, const char *key)
+static const char *dict_sockmap_query(DICT *dict, const char *key)
 {
-    const char *myname = "dict_sockmap_lookup";
+    const char *myname = "dict_sockmap_query";
     DICT_SOCKMAP *dp = (DICT_SOCKMAP *) dict;
     AUTO_CLNT *sockmap_clnt = DICT_SOCKMAP_RH_HANDLE(dp->client_info);
     VSTREAM *fp;
@@ -197,6 +206,20 @@ static const char *dict_sockmap_lookup(DICT *dict, const char *key)
 	    return (0);
 	}
 
+	/*
+	 * Between requests, the server must not send anything. If the
+	 * connection is readable, then the server has closed it (or is out
+	 * of sync); reconnect now instead of losing a round trip.
+	 */
+	if (except_count == 0
+	    && (vstream_peek(fp) > 0 || readable(vstream_fileno(fp)) != 0)) {
+	    if (msg_verbose)
+		msg_info("%s: connection to %s was closed by server",
+			 myname, DICT_SOCKMAP_RH_NAME(dp->client_info));
+	    auto_clnt_recover(sockmap_clnt);
+	    continue;
+	}
+
 	/*
 	 * Set up an exception handler.
 	 */
@@ -283,6 +306,17 @@ static const char *dict_sockmap_lookup(DICT *dict, const char *key)
     return (0);
 }
 
+/* dict_sockmap_lookup - look up key, optionally from cache */
+
+static const char *dict_sockmap_lookup(DICT *dict, const char *key)
+{
+    DICT_SOCKMAP *dp = (DICT_SOCKMAP *) dict;
+
+    if (dp->cache)
+	return (dict_result_cache_lookup(dp->cache, key));
+    return (dict_sockmap_query(dict, key));
+}
+
 /* dict_sockmap_close - close socket map */
 
 static void dict_sockmap_close(DICT *dict)
@@ -292,6 +326,8 @@ static void dict_sockmap_close(DICT *dict)
 
     if (dict_sockmap_handles == 0 || dict_sockmap_handles->used == 0)
 	msg_panic("%s: attempt to close a non-existent map", myname);
+    if (dp->cache)
+	dict_result_cache_free(dp->cache);
     vstring_free(dp->rdwr_buf);
     myfree(dp->sockmap_name);
     if (--DICT_SOCKMAP_RH_REFCOUNT(dp->client_info) == 0) {
@@ -379,6 +415,7 @@ DICT   *dict_sockmap_open(const char *mapname, int open_flags, int dict_flags)
     dp->dict.close = dict_sockmap_close;
     /* Don't look up parent domains or network superblocks. */
     dp->dict.flags = dict_flags | DICT_FLAG_PATTERN;
+    dp->cache = dict_result_cache_create(&dp->dict, dict_sockmap_query);
 
     DICT_SOCKMAP_OPEN_RETURN(DICT_DEBUG (&dp->dict));
 }
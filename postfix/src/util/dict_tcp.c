@@ -18,6 +18,12 @@
 /*
 /*	Map names have the form host:port.
 /*
+/*	The client keeps its connection to the server between lookups.
+/*	Before a connection is reused, the client checks that the
+/*	server has not closed it, so that an idle timeout in the
+/*	server does not cost a failed request. Lookup results may be
+/*	cached as described in dict_result_cache(3).
+/*
 /*	The TCP map class implements a very simple protocol: the client
 /*	sends a request, and the server sends one reply. Requests and
 /*	replies are sent as one line of ASCII text, terminated by the
@@ -59,6 +65,7 @@
 /*	because neither the connection nor the server are authenticated.
 /* SEE ALSO
 /*	dict(3) generic dictionary manager
+/*	dict_result_cache(3) lookup result cache
 /*	hex_quote(3) http-style quoting
 /* DIAGNOSTICS
 /*	Fatal errors: out of memory, unknown host or service name,
@@ -92,9 +99,11 @@
 #include <vstream.h>
 #include <vstring_vstream.h>
 #include <connect.h>
+#include <iostuff.h>
 #include <hex_quote.h>
 #include <dict.h>
 #include <stringops.h>
+#include <dict_result_cache.h>
 #include <dict_tcp.h>
 
 /* Application-specific. */
@@ -104,6 +113,7 @@ typedef struct {
     VSTRING *raw_buf;			/* raw I/O buffer */
     VSTRING *hex_buf;			/* quoted I/O buffer */
     VSTREAM *fp;			/* I/O stream */
+    DICT_RESULT_CACHE *cache;		/* optional result cache */
 } DICT_TCP;
 
 #define DICT_TCP_MAXTRY	10		/* attempts before giving up */
@@ -149,13 +159,14 @@ static void dict_tcp_disconnect(DICT_TCP *dict_tcp)
     dict_tcp->fp = 0;
 }
 
-/* dict_tcp_lookup - request TCP server */
+/* dict_tcp_query - request TCP server */
 
-static const char *dict_tcp_lookup(DICT *dict, const char *key)
+static const char *dict_tcp_query(DICT *dict, const char *key)
 {
     DICT_TCP *dict_tcp = (DICT_TCP *) dict;
-    const char *myname = "dict_tcp_lookup";
+    const char *myname = "dict_tcp_query";
     int     tries;
+    int     reused;
     char   *start;
     int     last_ch;
 
@@ -175,10 +186,25 @@ static const char *dict_tcp_lookup(DICT *dict, const char *key)
     }
     for (tries = 0; /* see below */ ; /* see below */ ) {
 
+	/*
+	 * Between requests, the server must not send anything. If the
+	 * connection is readable, then the server has closed it (or is out
+	 * of sync), and we would lose a round trip finding out the hard way.
+	 */
+	if (dict_tcp->fp != 0
+	    && (vstream_peek(dict_tcp->fp) > 0
+		|| readable(vstream_fileno(dict_tcp->fp)) != 0)) {
+	    if (msg_verbose)
+		msg_info("%s: connection to %s was closed by server",
+			 myname, dict_tcp->dict.name);
+	    dict_tcp_disconnect(dict_tcp);
+	}
+
 	/*
 	 * Connect to the server, or use an existing connection.
 	 */
-	if (dict_tcp->fp != 0 || dict_tcp_connect(dict_tcp) == 0) {
+	reused = (dict_tcp->fp != 0);
+	if (reused || dict_tcp_connect(dict_tcp) == 0) {
 
 	    /*
 	     * Send request and receive response. Both are %XX quoted and
@@ -213,9 +239,12 @@ static const char *dict_tcp_lookup(DICT *dict, const char *key)
 	    RETURN(DICT_ERR_RETRY, 0);
 
 	/*
-	 * Sleep between attempts, instead of hammering the server.
+	 * Sleep between attempts, instead of hammering the server. A
+	 * connection that failed after reuse is retried immediately, as a
+	 * server may drop idle connections at any time.
 	 */
-	sleep(1);
+	if (!reused)
+	    sleep(1);
     }
     if (msg_verbose)
 	msg_info("%s: recv: %s", myname, STR(dict_tcp->hex_buf));
@@ -245,10 +274,10 @@ static const char *dict_tcp_lookup(DICT *dict, const char *key)
 	dict_tcp_disconnect(dict_tcp);
 	RETURN(DICT_ERR_RETRY, 0);
     case '4':
+	/* The reply was well-formed; keep the connection. */
 	if (msg_verbose)
 	    msg_info("%s: soft error: %s",
 		     myname, printable(STR(dict_tcp->hex_buf), '_'));
-	dict_tcp_disconnect(dict_tcp);
 	RETURN(DICT_ERR_RETRY, 0);
     case '5':
 	if (msg_verbose)
@@ -263,6 +292,17 @@ static const char *dict_tcp_lookup(DICT *dict, const char *key)
     }
 }
 
+/* dict_tcp_lookup - look up key, optionally from cache */
+
+static const char *dict_tcp_lookup(DICT *dict, const char *key)
+{
+    DICT_TCP *dict_tcp = (DICT_TCP *) dict;
+
+    if (dict_tcp->cache)
+	return (dict_result_cache_lookup(dict_tcp->cache, key));
+    return (dict_tcp_query(dict, key));
+}
+
 /* dict_tcp_close - close TCP map */
 
 static void dict_tcp_close(DICT *dict)
@@ -271,6 +311,8 @@ static void dict_tcp_close(DICT *dict)
 
     if (dict_tcp->fp)
 	(void) vstream_fclose(dict_tcp->fp);
+    if (dict_tcp->cache)
+	dict_result_cache_free(dict_tcp->cache);
     if (dict_tcp->raw_buf)
 	vstring_free(dict_tcp->raw_buf);
     if (dict_tcp->hex_buf)
@@ -310,6 +352,8 @@ DICT   *dict_tcp_open(const char *map, int open_flags, int dict_flags)
     dict_tcp->dict.flags = dict_flags | DICT_FLAG_PATTERN;
     if (dict_flags & DICT_FLAG_FOLD_MUL)
 	dict_tcp->dict.fold_buf = vstring_alloc(10);
+    dict_tcp->cache = dict_result_cache_create(&dict_tcp->dict,
+					       dict_tcp_query);
 
     return (DICT_DEBUG (&dict_tcp->dict));
 }
@@ -25,6 +25,11 @@
 /*	void	(*callback)(int event, void *context);
 /*	void	*context;
 /*
+/*	int	event_enable_read_excl(fd, callback, context)
+/*	int	fd;
+/*	void	(*callback)(int event, void *context);
+/*	void	*context;
+/*
 /*	void	event_enable_write(fd, callback, context)
 /*	int	fd;
 /*	void	(*callback)(int event, void *context);
@@ -85,6 +90,16 @@
 /*	kernel-based event filters this is preferred usage, because
 /*	each disable and enable request would cost a system call.
 /*
+/*	event_enable_read_excl() is like event_enable_read(), but
+/*	asks the kernel to wake up only one of the processes that
+/*	wait for the same I/O channel, instead of all of them. The
+/*	result is non-zero when the request was honored; zero means
+/*	that the system has no such feature (on Linux, a kernel
+/*	before 4.5), or that the channel was already enabled with
+/*	event_enable_read().  Processes
+/*	that share a non-blocking listening socket can use this to
+/*	avoid a thundering herd without external locking.
+/*
 /*	The manifest constants EVENT_NULL_CONTEXT and EVENT_NULL_TYPE
 /*	provide convenient null values.
 /*
@@ -472,6 +487,22 @@ static int event_epollfd;		/* epoll handle */
 #define EVENT_REG_ADD_WRITE(e, f)  EVENT_REG_ADD_OP((e), (f), EPOLLOUT)
 #define EVENT_REG_ADD_TEXT         "epoll_ctl EPOLL_CTL_ADD"
 
+ /*
+  * Linux 4.5 and later wake up only one process from among those that wait
+  * for the same descriptor with EPOLLEXCLUSIVE. Earlier kernels accept the
+  * flag without error, but ignore it and wake up all of them; the kernel
+  * version is therefore checked at run time. Specify -DNO_EPOLLEXCLUSIVE to
+  * build without.
+  */
+#if defined(EPOLLEXCLUSIVE) && !defined(NO_EPOLLEXCLUSIVE)
+#include <stdio.h>
+#include <sys/utsname.h>
+#define EVENT_REG_ADD_READ_EXCL(e, f) \
+	EVENT_REG_ADD_OP((e), (f), EPOLLIN | EPOLLEXCLUSIVE)
+#define EVENT_EXCL_MIN_MAJOR	4
+#define EVENT_EXCL_MIN_MINOR	5
+#endif
+
 #define EVENT_REG_DEL_OP(e, f, ev) EVENT_REG_FD_OP((e), (f), (ev), EPOLL_CTL_DEL)
 #define EVENT_REG_DEL_READ(e, f)   EVENT_REG_DEL_OP((e), (f), EPOLLIN)
 #define EVENT_REG_DEL_WRITE(e, f)  EVENT_REG_DEL_OP((e), (f), EPOLLOUT)
@@ -496,6 +527,14 @@ typedef struct epoll_event EVENT_BUFFER;
 #define EVENT_TEST_READ(bp)	(EVENT_GET_TYPE(bp) & EPOLLIN)
 #define EVENT_TEST_WRITE(bp)	(EVENT_GET_TYPE(bp) & EPOLLOUT)
 
+#endif
+
+ /*
+  * Descriptors that were registered for exclusive wakeup, so that
+  * event_fork() can register them in the same manner.
+  */
+#ifdef EVENT_REG_ADD_READ_EXCL
+static EVENT_MASK event_emask;		/* exclusive read events */
 #endif
 
  /*
@@ -579,6 +618,9 @@ static void event_init(void)
     EVENT_MASK_ALLOC(&event_rmask, event_fdslots);
     EVENT_MASK_ALLOC(&event_wmask, event_fdslots);
     EVENT_MASK_ALLOC(&event_xmask, event_fdslots);
+#ifdef EVENT_REG_ADD_READ_EXCL
+    EVENT_MASK_ALLOC(&event_emask, event_fdslots);
+#endif
 
     /*
      * Initialize the kernel-based filter.
@@ -634,6 +676,9 @@ static void event_extend(int fd)
     EVENT_MASK_REALLOC(&event_rmask, new_slots);
     EVENT_MASK_REALLOC(&event_wmask, new_slots);
     EVENT_MASK_REALLOC(&event_xmask, new_slots);
+#ifdef EVENT_REG_ADD_READ_EXCL
+    EVENT_MASK_REALLOC(&event_emask, new_slots);
+#endif
 #endif
 #ifdef EVENT_REG_UPD_HANDLE
     EVENT_REG_UPD_HANDLE(err, new_slots);
@@ -718,17 +763,55 @@ void    event_fork(void)
 	} else if (EVENT_MASK_ISSET(fd, &event_rmask)) {
 	    EVENT_MASK_CLR(fd, &event_rmask);
 	    fdp = event_fdtable + fd;
+#ifdef EVENT_REG_ADD_READ_EXCL
+	    if (EVENT_MASK_ISSET(fd, &event_emask)) {
+		EVENT_MASK_CLR(fd, &event_emask);
+		(void) event_enable_read_excl(fd, fdp->callback, fdp->context);
+		continue;
+	    }
+#endif
 	    event_enable_read(fd, fdp->callback, fdp->context);
 	}
     }
 #endif
 }
 
-/* event_enable_read - enable read events */
+#ifdef EVENT_REG_ADD_READ_EXCL
 
-void    event_enable_read(int fd, EVENT_NOTIFY_RDWR_FN callback, void *context)
+/* event_excl_supported - does the kernel honor EPOLLEXCLUSIVE */
+
+static int event_excl_supported(void)
+{
+    static int supported = -1;
+    struct utsname uts;
+    int     major;
+    int     minor;
+
+    if (supported < 0) {
+	if (uname(&uts) < 0) {
+	    msg_warn("uname: %m");
+	    supported = 0;
+	} else {
+	    supported = (sscanf(uts.release, "%d.%d", &major, &minor) == 2
+			 && (major > EVENT_EXCL_MIN_MAJOR
+			     || (major == EVENT_EXCL_MIN_MAJOR
+				 && minor >= EVENT_EXCL_MIN_MINOR)));
+	    if (msg_verbose)
+		msg_info("kernel %s: exclusive wakeup is %ssupported",
+			 uts.release, supported ? "" : "not ");
+	}
+    }
+    return (supported);
+}
+
+#endif
+
+/* event_enable_read_mode - enable read events */
+
+static int event_enable_read_mode(const char *myname, int fd,
+				  EVENT_NOTIFY_RDWR_FN callback,
+				  void *context, int excl)
 {
-    const char *myname = "event_enable_read";
     EVENT_FDTABLE *fdp;
     int     err;
 
@@ -767,7 +850,16 @@ void    event_enable_read(int fd, EVENT_NOTIFY_RDWR_FN callback, void *context)
 	if (event_max_fd < fd)
 	    event_max_fd = fd;
 #if (EVENTS_STYLE != EVENTS_STYLE_SELECT)
-	EVENT_REG_ADD_READ(err, fd);
+#ifdef EVENT_REG_ADD_READ_EXCL
+	if (excl && event_excl_supported()) {
+	    EVENT_REG_ADD_READ_EXCL(err, fd);
+	    if (err == 0)
+		EVENT_MASK_SET(fd, &event_emask);
+	    else if (errno == EINVAL)
+		EVENT_REG_ADD_READ(err, fd);
+	} else
+#endif
+	    EVENT_REG_ADD_READ(err, fd);
 	if (err < 0)
 	    msg_fatal("%s: %s: %m", myname, EVENT_REG_ADD_TEXT);
 #endif
@@ -777,6 +869,28 @@ void    event_enable_read(int fd, EVENT_NOTIFY_RDWR_FN callback, void *context)
 	fdp->callback = callback;
 	fdp->context = context;
     }
+#ifdef EVENT_REG_ADD_READ_EXCL
+    return (EVENT_MASK_ISSET(fd, &event_emask) != 0);
+#else
+    return (0);
+#endif
+}
+
+/* event_enable_read - enable read events */
+
+void    event_enable_read(int fd, EVENT_NOTIFY_RDWR_FN callback, void *context)
+{
+    (void) event_enable_read_mode("event_enable_read", fd,
+				  callback, context, 0);
+}
+
+/* event_enable_read_excl - enable read events, exclusive wakeup */
+
+int     event_enable_read_excl(int fd, EVENT_NOTIFY_RDWR_FN callback,
+			       void *context)
+{
+    return (event_enable_read_mode("event_enable_read_excl", fd,
+				   callback, context, 1));
 }
 
 /* event_enable_write - enable write events */
@@ -884,6 +998,9 @@ void    event_disable_readwrite(int fd)
     EVENT_MASK_CLR(fd, &event_xmask);
     EVENT_MASK_CLR(fd, &event_rmask);
     EVENT_MASK_CLR(fd, &event_wmask);
+#ifdef EVENT_REG_ADD_READ_EXCL
+    EVENT_MASK_CLR(fd, &event_emask);
+#endif
     fdp = event_fdtable + fd;
     fdp->callback = 0;
     fdp->context = 0;
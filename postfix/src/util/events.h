@@ -26,6 +26,7 @@ typedef void (*EVENT_NOTIFY_FN) (int, void *);
 
 extern time_t event_time(void);
 extern void event_enable_read(int, EVENT_NOTIFY_RDWR_FN, void *);
+extern int event_enable_read_excl(int, EVENT_NOTIFY_RDWR_FN, void *);
 extern void event_enable_write(int, EVENT_NOTIFY_RDWR_FN, void *);
 extern void event_disable_readwrite(int);
 extern time_t event_request_timer(EVENT_NOTIFY_TIME_FN, void *, int);
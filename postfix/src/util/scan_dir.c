@@ -24,6 +24,10 @@
 /*
 /*	SCAN_DIR *scan_dir_close(scan)
 /*	SCAN_DIR *scan;
+/*
+/*	void	scan_dir_batch(scan, limit)
+/*	SCAN_DIR *scan;
+/*	int	limit;
 /* DESCRIPTION
 /*	These functions scan directories for names. The "." and
 /*	".." names are skipped. Essentially, this is <dirent>
@@ -47,6 +51,16 @@
 /*	scan_dir_pop() leaves the directory being scanned and returns
 /*	to the previous one. The result is the argument, null if no
 /*	previous directory information is available.
+/*
+/*	scan_dir_batch() changes the order in which scan_dir_next()
+/*	returns names. Instead of directory order, scan_dir_next()
+/*	reads up to \fIlimit\fR names at a time and returns them
+/*	in inode number order. On many file systems, that reduces
+/*	disk seeks when the caller opens or stats each file and
+/*	the inodes are not in the cache. A name returned in this
+/*	mode remains valid until the next scan_dir_next() call that
+/*	reads a new batch from the same directory. Specify a zero
+/*	limit to turn off this mode.
 /* DIAGNOSTICS
 /*	All errors are fatal.
 /* LICENSE
@@ -78,6 +92,7 @@
 #endif
 #endif
 #include <string.h>
+#include <stdlib.h>			/* qsort() */
 #include <errno.h>
 
 /* Utility library. */
@@ -95,16 +110,27 @@
   */
 typedef struct SCAN_INFO SCAN_INFO;
 
+typedef struct {
+    ino_t   ino;			/* inode number */
+    char   *name;			/* directory entry name */
+} SCAN_ENTRY;
+
 struct SCAN_INFO {
     char   *path;			/* directory name */
     DIR    *dir;			/* directory structure */
+    SCAN_ENTRY *batch;			/* names in inode order */
+    int     batch_size;			/* allocated batch size */
+    int     batch_len;			/* names in batch */
+    int     batch_pos;			/* next name in batch */
     SCAN_INFO *parent;			/* linkage */
 };
 struct SCAN_DIR {
     SCAN_INFO *current;			/* current scan */
+    int     batch_limit;		/* 0, or inode-order batch size */
 };
 
 #define SCAN_DIR_PATH(scan)	(scan->current->path)
+#define STREQ(x,y)		(strcmp((x),(y)) == 0)
 #define STR(x)			vstring_str(x)
 
 /* scan_dir_path - return the path of the directory being read.  */
@@ -130,6 +156,8 @@ void    scan_dir_push(SCAN_DIR *scan, const char *path)
 	msg_fatal("%s: open directory %s: %m", myname, info->path);
     if (msg_verbose > 1)
 	msg_info("%s: open %s", myname, info->path);
+    info->batch = 0;
+    info->batch_size = info->batch_len = info->batch_pos = 0;
     info->parent = scan->current;
     scan->current = info;
 }
@@ -149,6 +177,11 @@ SCAN_DIR *scan_dir_pop(SCAN_DIR *scan)
 	msg_fatal("%s: close directory %s: %m", myname, info->path);
     if (msg_verbose > 1)
 	msg_info("%s: close %s", myname, info->path);
+    if (info->batch) {
+	while (info->batch_len > 0)
+	    myfree(info->batch[--info->batch_len].name);
+	myfree((void *) info->batch);
+    }
     myfree(info->path);
     myfree((void *) info);
     scan->current = parent;
@@ -163,10 +196,67 @@ SCAN_DIR *scan_dir_open(const char *path)
 
     scan = (SCAN_DIR *) mymalloc(sizeof(*scan));
     scan->current = 0;
+    scan->batch_limit = 0;
     scan_dir_push(scan, path);
     return (scan);
 }
 
+/* scan_dir_batch - return names in inode order */
+
+void    scan_dir_batch(SCAN_DIR *scan, int limit)
+{
+    scan->batch_limit = (limit > 0 ? limit : 0);
+}
+
+/* scan_dir_compare - qsort() call-back */
+
+static int scan_dir_compare(const void *a, const void *b)
+{
+    ino_t   ia = ((const SCAN_ENTRY *) a)->ino;
+    ino_t   ib = ((const SCAN_ENTRY *) b)->ino;
+
+    return (ia < ib ? -1 : ia > ib ? 1 : 0);
+}
+
+/* scan_dir_refill - read next batch of names */
+
+static int scan_dir_refill(SCAN_DIR *scan, SCAN_INFO *info)
+{
+    const char *myname = "scan_dir_refill";
+    struct dirent *dp;
+
+    while (info->batch_len > 0)
+	myfree(info->batch[--info->batch_len].name);
+    info->batch_pos = 0;
+    if (info->batch_size != scan->batch_limit) {
+	if (info->batch)
+	    myfree((void *) info->batch);
+	info->batch_size = scan->batch_limit;
+	info->batch = (SCAN_ENTRY *)
+	    mymalloc(sizeof(*info->batch) * info->batch_size);
+    }
+
+    /*
+     * The dirent d_ino member is part of POSIX, so this costs no stat()
+     * calls.
+     */
+    errno = 0;
+    while (info->batch_len < info->batch_size
+	   && (dp = readdir(info->dir)) != 0) {
+	if (STREQ(dp->d_name, ".") || STREQ(dp->d_name, ".."))
+	    continue;
+	info->batch[info->batch_len].ino = dp->d_ino;
+	info->batch[info->batch_len].name = mystrdup(dp->d_name);
+	info->batch_len += 1;
+    }
+    if (info->batch_len > 1)
+	qsort((void *) info->batch, info->batch_len, sizeof(*info->batch),
+	      scan_dir_compare);
+    if (msg_verbose > 1)
+	msg_info("%s: %s: %d names", myname, info->path, info->batch_len);
+    return (info->batch_len);
+}
+
 /* scan_dir_next - find next entry */
 
 char   *scan_dir_next(SCAN_DIR *scan)
@@ -175,8 +265,14 @@ char   *scan_dir_next(SCAN_DIR *scan)
     SCAN_INFO *info = scan->current;
     struct dirent *dp;
 
-#define STREQ(x,y)	(strcmp((x),(y)) == 0)
-
+    if (info && scan->batch_limit > 0) {
+	if (info->batch_pos >= info->batch_len
+	    && scan_dir_refill(scan, info) == 0)
+	    return (0);
+	if (msg_verbose > 1)
+	    msg_info("%s: found %s", myname, info->batch[info->batch_pos].name);
+	return (info->batch[info->batch_pos++].name);
+    }
     if (info) {
 
 	/*
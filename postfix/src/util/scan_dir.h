@@ -22,6 +22,7 @@ extern char *scan_dir_path(SCAN_DIR *);
 extern void scan_dir_push(SCAN_DIR *, const char *);
 extern SCAN_DIR *scan_dir_pop(SCAN_DIR *);
 extern SCAN_DIR *scan_dir_close(SCAN_DIR *);
+extern void scan_dir_batch(SCAN_DIR *, int);
 
 /* LICENSE
 /* .ad
@@ -0,0 +1,211 @@
+/*++
+/* NAME
+/*	set_cpu_affinity 3
+/* SUMMARY
+/*	restrict process to a set of CPUs
+/* SYNOPSIS
+/*	#include <set_cpu_affinity.h>
+/*
+/*	void	set_cpu_affinity(spec)
+/*	const char *spec;
+/* DESCRIPTION
+/*	set_cpu_affinity() restricts the calling process, and the
+/*	processes that it will create, to the CPUs in the specified
+/*	list. The list contains CPU numbers, or ranges of CPU numbers
+/*	(\fIlow\fR-\fIhigh\fR), separated by comma or whitespace.
+/*
+/*	On Linux systems, an element of the form node:\fInumber\fR
+/*	specifies all the CPUs of that NUMA node, as listed in
+/*	/sys/devices/system/node/node\fInumber\fR/cpulist. With the
+/*	default memory policy, a process that runs on a node's CPUs
+/*	allocates its memory from that node.
+/*
+/*	An empty list leaves the process affinity unchanged.
+/* DIAGNOSTICS
+/*	Fatal error: malformed list. Warning: the system does not
+/*	support CPU affinity, a NUMA node is unknown, or the list
+/*	contains no usable CPU; the process affinity is then left
+/*	unchanged.
+/* SEE ALSO
+/*	sched_setaffinity(2)
+/* LICENSE
+/* .ad
+/* .fi
+/*	The Secure Mailer license must be distributed with this software.
+/*--*/
+
+/* System library. */
+
+#define _GNU_SOURCE			/* Linux sched_setaffinity(), CPU_SET() */
+#include <sys_defs.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <ctype.h>
+#include <errno.h>
+
+#ifdef HAS_SCHED_AFFINITY
+#include <sched.h>
+#endif
+
+/* Utility library. */
+
+#include <msg.h>
+#include <mymalloc.h>
+#include <stringops.h>
+#include <vstream.h>
+#include <vstring.h>
+#include <vstring_vstream.h>
+#include <set_cpu_affinity.h>
+
+#ifdef HAS_SCHED_AFFINITY
+
+#define NODE_PREFIX	"node:"
+#define NODE_CPULIST	"/sys/devices/system/node/node%s/cpulist"
+
+/* cpu_number - convert CPU number */
+
+static int cpu_number(const char *str, char **end)
+{
+    unsigned long num;
+
+    if (!ISDIGIT(*str))
+	return (-1);
+    errno = 0;
+    num = strtoul(str, end, 10);
+    if (errno != 0 || num >= CPU_SETSIZE)
+	return (-1);
+    return ((int) num);
+}
+
+/* cpu_list_add - add CPU numbers and ranges to set */
+
+static int cpu_list_add(cpu_set_t *set, const char *spec)
+{
+    char   *saved_list;
+    char   *cp;
+    char   *elem;
+    char   *end;
+    int     low;
+    int     high;
+    int     ret = 0;
+
+    cp = saved_list = mystrdup(spec);
+    while (ret == 0 && (elem = mystrtok(&cp, CHARS_COMMA_SP)) != 0) {
+	if ((low = high = cpu_number(elem, &end)) < 0)
+	    ret = -1;
+	else if (*end == '-' && (high = cpu_number(end + 1, &end)) < low)
+	    ret = -1;
+	else if (*end != 0)
+	    ret = -1;
+	else
+	    for ( /* void */ ; low <= high; low++)
+		CPU_SET(low, set);
+    }
+    myfree(saved_list);
+    return (ret);
+}
+
+/* node_list_add - add CPUs of NUMA node to set */
+
+static int node_list_add(cpu_set_t *set, const char *node)
+{
+    VSTRING *buf;
+    VSTREAM *fp;
+    int     ret = 0;
+
+    buf = vstring_alloc(100);
+    vstring_sprintf(buf, NODE_CPULIST, node);
+    if ((fp = vstream_fopen(vstring_str(buf), O_RDONLY, 0)) == 0) {
+	msg_warn("open %s: %m", vstring_str(buf));
+	ret = -1;
+    } else {
+	if (vstring_get_nonl(buf, fp) == VSTREAM_EOF
+	    || cpu_list_add(set, vstring_str(buf)) < 0) {
+	    msg_warn("node %s: cannot parse CPU list", node);
+	    ret = -1;
+	}
+	(void) vstream_fclose(fp);
+    }
+    vstring_free(buf);
+    return (ret);
+}
+
+#endif
+
+/* set_cpu_affinity - restrict process to set of CPUs */
+
+void    set_cpu_affinity(const char *spec)
+{
+    const char *myname = "set_cpu_affinity";
+
+#ifdef HAS_SCHED_AFFINITY
+    cpu_set_t set;
+    char   *saved_spec;
+    char   *cp;
+    char   *elem;
+    const char *node;
+
+    if (*spec == 0)
+	return;
+    CPU_ZERO(&set);
+    cp = saved_spec = mystrdup(spec);
+    while ((elem = mystrtok(&cp, CHARS_COMMA_SP)) != 0) {
+	if (strncasecmp(elem, NODE_PREFIX, sizeof(NODE_PREFIX) - 1) == 0) {
+	    node = elem + sizeof(NODE_PREFIX) - 1;
+	    if (*node == 0 || !alldig(node))
+		msg_fatal("bad NUMA node \"%s\" in CPU list \"%s\"", elem, spec);
+	    if (node_list_add(&set, node) < 0) {
+		myfree(saved_spec);
+		return;
+	    }
+	} else if (cpu_list_add(&set, elem) < 0) {
+	    msg_fatal("bad CPU number or range \"%s\" in CPU list \"%s\"",
+		      elem, spec);
+	}
+    }
+    myfree(saved_spec);
+    if (sched_setaffinity(0, sizeof(set), &set) < 0)
+	msg_warn("%s: CPU list \"%s\": %m", myname, spec);
+    else if (msg_verbose)
+	msg_info("%s: CPU list \"%s\"", myname, spec);
+#else
+    if (*spec != 0)
+	msg_warn("%s: CPU affinity is not supported on this system; "
+		 "ignoring CPU list \"%s\"", myname, spec);
+#endif
+}
+
+#ifdef TEST
+
+ /*
+  * Proof-of-concept test program. Set the affinity, then show the result.
+  */
+#include <unistd.h>
+#include <msg_vstream.h>
+
+int     main(int argc, char **argv)
+{
+    msg_vstream_init(argv[0], VSTREAM_ERR);
+    if (argc != 2)
+	msg_fatal("usage: %s cpu-list", argv[0]);
+    msg_verbose = 1;
+    set_cpu_affinity(argv[1]);
+#ifdef HAS_SCHED_AFFINITY
+    {
+	cpu_set_t set;
+	int     cpu;
+
+	if (sched_getaffinity(0, sizeof(set), &set) < 0)
+	    msg_fatal("sched_getaffinity: %m");
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
+	    if (CPU_ISSET(cpu, &set))
+		vstream_printf("%d ", cpu);
+	vstream_printf("\n");
+	vstream_fflush(VSTREAM_OUT);
+    }
+#endif
+    exit(0);
+}
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef _SET_CPU_AFFINITY_H_INCLUDED_
+#define _SET_CPU_AFFINITY_H_INCLUDED_
+
+/*++
+/* NAME
+/*	set_cpu_affinity 3h
+/* SUMMARY
+/*	restrict process to a set of CPUs
+/* SYNOPSIS
+/*	#include <set_cpu_affinity.h>
+/* DESCRIPTION
+/* .nf
+
+ /* External interface. */
+
+extern void set_cpu_affinity(const char *);
+
+/* LICENSE
+/* .ad
+/* .fi
+/*	The Secure Mailer license must be distributed with this software.
+/*--*/
+
+#endif
@@ -55,6 +55,10 @@
 /*	The shell to use when executing the command specified with
 /*	CA_SPAWN_CMD_COMMAND. This shell is invoked regardless of the
 /*	command content.
+/* .IP "CA_SPAWN_CMD_EXEC_DELAY(double *)"
+/*	Storage for the time in seconds from fork() until the child
+/*	process executes the command, or terminates when it cannot
+/*	execute the command.
 /* .RE
 /* DIAGNOSTICS
 /*	Panic: interface violations (for example, a missing command).
@@ -79,6 +83,7 @@
 
 #include <sys_defs.h>
 #include <sys/wait.h>
+#include <sys/time.h>
 #include <signal.h>
 #include <unistd.h>
 #include <errno.h>
@@ -92,6 +97,7 @@
 /* Utility library. */
 
 #include <msg.h>
+#include <iostuff.h>
 #include <timed_wait.h>
 #include <set_ugid.h>
 #include <argv.h>
@@ -113,6 +119,7 @@ struct spawn_args {
     char  **export;			/* exportable environment */
     char   *shell;			/* command shell */
     int     time_limit;			/* command time limit */
+    double *exec_delay;			/* fork-to-exec time */
 };
 
 /* get_spawn_args - capture the variadic argument list */
@@ -136,6 +143,7 @@ static void get_spawn_args(struct spawn_args * args, int init_key, va_list ap)
     args->export = 0;
     args->shell = 0;
     args->time_limit = 0;
+    args->exec_delay = 0;
 
     /*
      * Then, override the defaults with user-supplied inputs.
@@ -185,6 +193,9 @@ static void get_spawn_args(struct spawn_args * args, int init_key, va_list ap)
 	case SPAWN_CMD_SHELL:
 	    args->shell = va_arg(ap, char *);
 	    break;
+	case SPAWN_CMD_EXEC_DELAY:
+	    args->exec_delay = va_arg(ap, double *);
+	    break;
 	default:
 	    msg_panic("%s: unknown key: %d", myname, key);
 	}
@@ -208,6 +219,10 @@ WAIT_STATUS_T spawn_command(int key,...)
     char  **cpp;
     ARGV   *argv;
     int     err;
+    int     exec_pipe[2];
+    struct timeval fork_time;
+    struct timeval exec_time;
+    char    ch;
 
     /*
      * Process the variadic argument list. This also does sanity checks on
@@ -228,7 +243,16 @@ WAIT_STATUS_T spawn_command(int key,...)
      * user. This includes revoking all rights on open files (via the close
      * on exec flag). If we cannot run the command now, try again some time
      * later.
+     * 
+     * To find out when the child executes the command, give it the write end
+     * of a pipe that is closed upon exec.
      */
+    if (args.exec_delay) {
+	if (pipe(exec_pipe) < 0)
+	    msg_fatal("%s: pipe: %m", myname);
+	close_on_exec(exec_pipe[1], CLOSE_ON_EXEC);
+	GETTIMEOFDAY(&fork_time);
+    }
     switch (pid = fork()) {
 
 	/*
@@ -243,6 +267,8 @@ WAIT_STATUS_T spawn_command(int key,...)
 	 * parent can kill not just the child but also its offspring.
 	 */
     case 0:
+	if (args.exec_delay)
+	    (void) close(exec_pipe[0]);
 	if (args.uid != (uid_t) - 1 || args.gid != (gid_t) - 1)
 	    set_ugid(args.uid, args.gid);
 	setsid();
@@ -291,6 +317,21 @@ WAIT_STATUS_T spawn_command(int key,...)
 	 */
     default:
 
+	/*
+	 * Wait until the child executes the command or terminates.
+	 */
+	if (args.exec_delay) {
+	    (void) close(exec_pipe[1]);
+	    if (args.time_limit <= 0
+		|| read_wait(exec_pipe[0], args.time_limit) == 0)
+		while (read(exec_pipe[0], &ch, 1) < 0 && errno == EINTR)
+		     /* void */ ;
+	    GETTIMEOFDAY(&exec_time);
+	    (void) close(exec_pipe[0]);
+	    *args.exec_delay = exec_time.tv_sec - fork_time.tv_sec
+		+ (exec_time.tv_usec - fork_time.tv_usec) / 1000000.0;
+	}
+
 	/*
 	 * Be prepared for the situation that the child does not terminate.
 	 * Make sure that the child terminates before the parent attempts to
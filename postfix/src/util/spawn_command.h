@@ -29,6 +29,7 @@
 #define SPAWN_CMD_ENV		9	/* extra environment */
 #define SPAWN_CMD_SHELL		10	/* alternative shell */
 #define SPAWN_CMD_EXPORT	11	/* exportable parameters */
+#define SPAWN_CMD_EXEC_DELAY	12	/* fork-to-exec time */
 
 /* Safer API: type-checked arguments, external use. */
 #define CA_SPAWN_CMD_END	SPAWN_CMD_END
@@ -43,12 +44,14 @@
 #define CA_SPAWN_CMD_ENV(v)	SPAWN_CMD_ENV, CHECK_PPTR(CA_SPAWN_CMD, char, (v))
 #define CA_SPAWN_CMD_SHELL(v)	SPAWN_CMD_SHELL, CHECK_CPTR(CA_SPAWN_CMD, char, (v))
 #define CA_SPAWN_CMD_EXPORT(v)	SPAWN_CMD_EXPORT, CHECK_PPTR(CA_SPAWN_CMD, char, (v))
+#define CA_SPAWN_CMD_EXEC_DELAY(v) SPAWN_CMD_EXEC_DELAY, CHECK_PTR(CA_SPAWN_CMD, double, (v))
 
 CHECK_VAL_HELPER_DCL(CA_SPAWN_CMD, uid_t);
 CHECK_VAL_HELPER_DCL(CA_SPAWN_CMD, int);
 CHECK_VAL_HELPER_DCL(CA_SPAWN_CMD, gid_t);
 CHECK_PPTR_HELPER_DCL(CA_SPAWN_CMD, char);
 CHECK_CPTR_HELPER_DCL(CA_SPAWN_CMD, char);
+CHECK_PTR_HELPER_DCL(CA_SPAWN_CMD, double);
 
 extern WAIT_STATUS_T spawn_command(int,...);
 
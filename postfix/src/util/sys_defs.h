@@ -819,6 +819,13 @@ extern int initgroups(const char *, int);
 #define CANT_WRITE_BEFORE_SENDING_FD
 #endif
 #define PREFERRED_RAND_SOURCE	"dev:/dev/urandom"	/* introduced in 1.1 */
+#if HAVE_GLIBC_API_VERSION_SUPPORT(2, 14) \
+	&& (LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,39))
+#define HAS_SYNCFS
+#endif
+#if HAVE_GLIBC_API_VERSION_SUPPORT(2, 4)
+#define HAS_SCHED_AFFINITY
+#endif
 #ifndef NO_EPOLL
 #define EVENTS_STYLE	EVENTS_STYLE_EPOLL	/* introduced in 2.5 */
 #endif
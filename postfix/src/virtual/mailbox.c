@@ -117,8 +117,15 @@ static int deliver_mailbox_file(LOCAL_STATE state, USER_ATTR usr_attr)
 
     set_eugid(usr_attr.uid, usr_attr.gid);
     mp = mbox_open(usr_attr.mailbox, O_APPEND | O_WRONLY | O_CREAT,
-		   S_IRUSR | S_IWUSR, &st, -1, -1,
-		   virtual_mbox_lock_mask, "4.2.0", why);
+		   S_IRUSR | S_IWUSR, &st, -1, -1, virtual_mbox_lock_mask
+		   | (state.lock_nowait ? MBOX_LOCK_NOWAIT : 0), "4.2.0", why);
+    if (mp == 0 && state.lock_nowait && errno == EAGAIN) {
+	set_eugid(var_owner_uid, var_owner_gid);
+	if (msg_verbose)
+	    msg_info("%s: %s: mailbox is busy, will try again later",
+		     myname, usr_attr.mailbox);
+	return (VIRT_STAT_LOCK_BUSY);
+    }
     if (mp != 0) {
 	if (S_ISREG(st.st_mode) == 0) {
 	    vstream_fclose(mp->fp);
@@ -51,6 +51,12 @@
 /*	The mailbox is locked for exclusive access while delivery is in
 /*	progress. In case of problems, an attempt is made to truncate the
 /*	mailbox to its original length.
+/*
+/*	With a multi-recipient delivery request, a mailbox that is
+/*	locked by someone else is skipped, and delivery to that
+/*	mailbox is tried again after all other recipients (Postfix
+/*	3.1 and later). One busy mailbox therefore no longer delays
+/*	delivery to all other mailboxes in the same request.
 /* QMAIL MAILDIR FORMAT
 /* .ad
 /* .fi
@@ -65,6 +71,12 @@
 /*
 /*	By definition, \fBmaildir\fR format does not require application-level
 /*	file locking during mail delivery or retrieval.
+/*
+/*	On Linux systems with syncfs(2), a multi-recipient delivery
+/*	request writes all maildir files first, flushes them to
+/*	stable storage with one syncfs(2) call per file system, and
+/*	then moves them into place, instead of calling fsync(2) once
+/*	for each file (Postfix 3.1 and later).
 /* MAILBOX OWNERSHIP
 /* .ad
 /* .fi
@@ -301,6 +313,7 @@
 /* Utility library. */
 
 #include <msg.h>
+#include <mymalloc.h>
 #include <vstring.h>
 #include <vstream.h>
 #include <iostuff.h>
@@ -365,6 +378,9 @@ static int local_deliver(DELIVER_REQUEST *rqst, char *service)
     int     msg_stat;
     LOCAL_STATE state;
     USER_ATTR usr_attr;
+    char   *busy = 0;
+    int     busy_count = 0;
+    int     pass;
 
     if (msg_verbose)
 	msg_info("local_deliver: %s from %s", rqst->queue_id, rqst->sender);
@@ -386,19 +402,66 @@ static int local_deliver(DELIVER_REQUEST *rqst, char *service)
     RESET_USER_ATTR(usr_attr, state.level);
     state.request = rqst;
 
+    /*
+     * Don't let one busy mailbox stall deliveries to all other mailboxes
+     * in a multi-recipient request. During the first pass, skip recipients
+     * whose mailbox is locked by someone else, and try those again after
+     * all other recipients, this time waiting for the lock as usual.
+     */
+    if (rqst->rcpt_list.len > 1) {
+	state.lock_nowait = 1;
+	busy = mymalloc(rqst->rcpt_list.len);
+    } else {
+	state.lock_nowait = 0;
+    }
+
+    /*
+     * Don't fsync() each maildir file separately. Instead, write all maildir
+     * files for this request, flush them to stable storage with one syncfs()
+     * call per file system, then move them into place.
+     */
+#ifdef HAS_SYNCFS
+    state.maildir_batch = (rqst->rcpt_list.len > 1);
+#else
+    state.maildir_batch = 0;
+#endif
+
     /*
      * Iterate over each recipient named in the delivery request. When the
      * mail delivery status for a given recipient is definite (i.e. bounced
      * or delivered), update the message queue file and cross off the
      * recipient. Update the per-message delivery status.
      */
-    for (msg_stat = 0, rcpt = rqst->rcpt_list.info; rcpt < rcpt_end; rcpt++) {
-	state.msg_attr.rcpt = *rcpt;
-	rcpt_stat = deliver_recipient(state, usr_attr);
-	if (rcpt_stat == 0 && (rqst->flags & DEL_REQ_FLAG_SUCCESS))
-	    deliver_completed(state.msg_attr.fp, rcpt->offset);
-	msg_stat |= rcpt_stat;
+#define BUSY(rcpt) busy[(rcpt) - rqst->rcpt_list.info]
+
+    for (msg_stat = 0, pass = 0; pass < 2; pass++) {
+	for (rcpt = rqst->rcpt_list.info; rcpt < rcpt_end; rcpt++) {
+	    if (pass > 0 && BUSY(rcpt) == 0)
+		continue;
+	    state.msg_attr.rcpt = *rcpt;
+	    rcpt_stat = deliver_recipient(state, usr_attr);
+	    if (busy != 0 && (BUSY(rcpt) = (rcpt_stat == VIRT_STAT_LOCK_BUSY))) {
+		busy_count++;
+		continue;
+	    }
+	    if (rcpt_stat == VIRT_STAT_PENDING)
+		continue;
+	    if (rcpt_stat == 0 && (rqst->flags & DEL_REQ_FLAG_SUCCESS))
+		deliver_completed(state.msg_attr.fp, rcpt->offset);
+	    msg_stat |= rcpt_stat;
+	}
+	if (state.maildir_batch)
+	    msg_stat |= deliver_maildir_flush(rqst);
+	if (busy_count == 0)
+	    break;
+	if (msg_verbose)
+	    msg_info("%s: %s: %d busy mailbox(es), trying again",
+		     myname, rqst->queue_id, busy_count);
+	state.lock_nowait = 0;
+	busy_count = 0;
     }
+    if (busy != 0)
+	myfree(busy);
 
     deliver_attr_free(&state.msg_attr);
     return (msg_stat);
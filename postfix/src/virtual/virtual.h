@@ -93,8 +93,26 @@ typedef struct LOCAL_STATE {
     int     level;			/* nesting level, for logging */
     DELIVER_ATTR msg_attr;		/* message/recipient attributes */
     DELIVER_REQUEST *request;		/* as from queue manager */
+    int     lock_nowait;		/* don't wait for busy mailbox */
+    int     maildir_batch;		/* defer maildir fsync and rename */
 } LOCAL_STATE;
 
+ /*
+  * With a multi-recipient request, a recipient whose mailbox is locked by
+  * someone else is skipped, and is tried again after all other recipients.
+  * This status is never reported to the queue manager.
+  */
+#define VIRT_STAT_LOCK_BUSY	1
+
+ /*
+  * With a multi-recipient request, maildir files are flushed to stable
+  * storage and moved into place for all recipients at once. The status for
+  * each such recipient is reported by deliver_maildir_flush().
+  */
+#define VIRT_STAT_PENDING	2
+
+extern int deliver_maildir_flush(DELIVER_REQUEST *);
+
  /*
   * Bundle up some often-user attributes.
   */